@@ -22,6 +22,8 @@
 #include <ros/ros.h>
 #include <yaml-cpp/yaml.h>
 
+#include <algorithm>
+
 Config::Config(const std::string& filename)
 {
     auto root = YAML::LoadFile(filename);
@@ -83,7 +85,7 @@ tf2::Transform Config::parseTransform(const YAML::Node& node) const
     return tf2::Transform(rot, origin);
 }
 
-void Config::parseRoot(const YAML::Node& node)
+Entity Config::parseEntity(const YAML::Node& entity) const
 {
     // sensor type conversion
     std::map<std::string, Sensor::Type> typeMap = {
@@ -91,6 +93,55 @@ void Config::parseRoot(const YAML::Node& node)
         { "NonMarkerBased", Sensor::Type::NonMarkerBased }
     };
 
+    Entity entityData;
+    entityData.name = entity["entity"].as<std::string>("undefined");
+
+    // load filter config
+    entityData.filterConfig.alpha = entity["filterAlpha"].as<double>(0.1);
+
+    // fixed infrastructure (e.g. world cameras)
+    entityData.isStatic = entity["static"].as<bool>(false);
+
+    // rigidly attached to another entity (e.g. a payload)
+    entityData.attachedTo      = entity["attachedTo"].as<std::string>("");
+    entityData.attachTransform = parseTransform(entity["attachTransform"]);
+
+    // load the sensor data
+    for (const auto& sensor : entity["sensors"])
+    {
+        Sensor sensorData;
+        sensorData.name   = sensor["sensor"].as<std::string>("undefined");
+        sensorData.topic  = sensor["topic"].as<std::string>("undefined");
+        sensorData.type   = typeMap[sensor["type"].as<std::string>("MarkerBased")];
+        sensorData.sigma  = sensor["sigma"].as<double>(1.0);
+        sensorData.target = sensor["target"].as<std::string>("undefined");
+        sensorData.transf = parseTransform(sensor["transform"]);
+
+        // add the sensor
+        entityData.sensors.push_back(sensorData);
+    }
+
+    // load the markers
+    for (const auto& marker : entity["markers"])
+    {
+        Marker markerData;
+        markerData.id     = marker["marker"].as<int>(-1);
+        markerData.transf = parseTransform(marker["transform"]);
+
+        entityData.markers.push_back(markerData);
+    }
+
+    return entityData;
+}
+
+void Config::parseRoot(const YAML::Node& node)
+{
+    // eval mode conversion
+    std::map<std::string, Options::EvalMode> evalModeMap = {
+        { "Greedy", Options::EvalMode::Greedy },
+        { "Optimize", Options::EvalMode::Optimize }
+    };
+
     if (!node)
         ROS_ERROR("Config: Document is empty");
 
@@ -102,41 +153,9 @@ void Config::parseRoot(const YAML::Node& node)
 
     // load the entities
     for (const YAML::Node& entity : node["entities"])
-    {
-        Entity entityData;
-        entityData.name = entity["entity"].as<std::string>("undefined");
-
-        // load filter config
-        entityData.filterConfig.alpha = entity["filterAlpha"].as<double>(0.1);
+        m_entities.push_back(parseEntity(entity));
 
-        // load the sensor data
-        for (const auto& sensor : entity["sensors"])
-        {
-            Sensor sensorData;
-            sensorData.name   = sensor["sensor"].as<std::string>("undefined");
-            sensorData.topic  = sensor["topic"].as<std::string>("undefined");
-            sensorData.type   = typeMap[sensor["type"].as<std::string>("MarkerBased")];
-            sensorData.sigma  = sensor["sigma"].as<double>(1.0);
-            sensorData.target = sensor["target"].as<std::string>("undefined");
-            sensorData.transf = parseTransform(sensor["transform"]);
-
-            // add the sensor
-            entityData.sensors.push_back(sensorData);
-        }
-
-        // load the markers
-        for (const auto& marker : entity["markers"])
-        {
-            Marker markerData;
-            markerData.id     = marker["marker"].as<int>(-1);
-            markerData.transf = parseTransform(marker["transform"]);
-
-            entityData.markers.push_back(markerData);
-        }
-
-        // add the entity
-        m_entities.push_back(entityData);
-    }
+    resolveAttachments();
 
     // load the options
     const auto options = node["options"];
@@ -147,10 +166,20 @@ void Config::parseRoot(const YAML::Node& node)
         m_options.dbgGraphInterval     = options["dbgDumpGraphInterval"].as<double>(0);
         m_options.loopRate             = options["loopRate"].as<double>(60.0);
         m_options.decayDuration        = options["decayDuration"].as<double>(0.25);
+        m_options.edgeLifetimeFactor   = options["edgeLifetimeFactor"].as<double>(3.0);
+        m_options.maxEdgeLifetime      = options["maxEdgeLifetime"].as<double>(2.0);
+        m_options.edgeHysteresis       = options["edgeHysteresis"].as<double>(2.0);
         m_options.publishMarkers       = options["publishMarkers"].as<bool>(true);
         m_options.publishWorldSensors  = options["publishWorldSensors"].as<bool>(true);
         m_options.publishEntitySensors = options["publishEntitySensors"].as<bool>(true);
         m_options.publishPoseTopics    = options["publishPoseTopics"].as<bool>(true);
+        m_options.evalThreads          = options["evalThreads"].as<int>(1);
+        m_options.staticTolerance      = options["staticTolerance"].as<double>(0.05);
+        m_options.staticAngleTolerance = options["staticAngleTolerance"].as<double>(5.0);
+        m_options.evalMode             = evalModeMap[options["evalMode"].as<std::string>("Greedy")];
+        m_options.solverIterations     = options["solverIterations"].as<int>(2);
+        m_options.refineBudget         = options["refineBudget"].as<double>(0.0);
+        m_options.historySize          = options["historySize"].as<int>(120);
     }
 }
 
@@ -159,6 +188,133 @@ Options Config::options() const
     return m_options;
 }
 
+RigidAttachment Config::resolveRigid(const std::string& entity) const
+{
+    auto itr = m_attachments.find(entity);
+
+    if (itr != m_attachments.end())
+        return itr->second;
+
+    // not attached
+    RigidAttachment attachment;
+    attachment.carrier = entity;
+
+    return attachment;
+}
+
+std::vector<std::string> Config::attachedEntities(const std::string& carrier) const
+{
+    std::vector<std::string> out;
+    std::vector<std::string> parents = { carrier };
+
+    // follow the chains of attachments down from the given entity
+    // an entity is visited once, hence cycles end here
+    while (!parents.empty())
+    {
+        const auto parent = parents.back();
+        parents.pop_back();
+
+        for (const auto& entity : m_entities)
+        {
+            if (entity.attachedTo != parent || entity.name == carrier || std::find(out.begin(), out.end(), entity.name) != out.end())
+                continue;
+
+            out.push_back(entity.name);
+            parents.push_back(entity.name);
+        }
+    }
+
+    return out;
+}
+
+bool Config::entityFromString(const std::string& input, Entity& entity) const
+{
+    try
+    {
+        const auto node = YAML::Load(input);
+
+        if (!node.IsMap() || !node["entity"])
+            return false;
+
+        entity = parseEntity(node);
+    }
+    catch (const YAML::Exception& e)
+    {
+        ROS_WARN("Config: Cannot parse entity: %s", e.what());
+        return false;
+    }
+
+    return true;
+}
+
+void Config::addEntity(const Entity& entity)
+{
+    auto itr = std::find_if(m_entities.begin(), m_entities.end(), [&entity](const Entity& other) {
+        return other.name == entity.name;
+    });
+
+    if (itr != m_entities.end())
+        *itr = entity;
+    else
+        m_entities.push_back(entity);
+
+    resolveAttachments();
+}
+
+bool Config::removeEntity(const std::string& name)
+{
+    auto itr = std::find_if(m_entities.begin(), m_entities.end(), [&name](const Entity& other) {
+        return other.name == name;
+    });
+
+    if (itr == m_entities.end())
+        return false;
+
+    m_entities.erase(itr);
+    resolveAttachments();
+
+    return true;
+}
+
+void Config::resolveAttachments()
+{
+    m_attachments.clear();
+
+    std::map<std::string, const Entity*> entities;
+    for (const auto& entity : m_entities)
+        entities[entity.name] = &entity;
+
+    for (const auto& entity : m_entities)
+    {
+        if (entity.attachedTo.empty())
+            continue;
+
+        RigidAttachment attachment;
+        attachment.carrier = entity.name;
+
+        // walk up to the carrier, composing the transforms on the way
+        // a chain longer than the number of entities is a cycle
+        for (std::size_t depth = 0; depth <= m_entities.size(); ++depth)
+        {
+            auto itr = entities.find(attachment.carrier);
+
+            if (itr == entities.end() || itr->second->attachedTo.empty())
+                break;
+
+            attachment.transform = itr->second->attachTransform * attachment.transform;
+            attachment.carrier   = itr->second->attachedTo;
+        }
+
+        if (!entities.count(attachment.carrier) || !entities[attachment.carrier]->attachedTo.empty())
+        {
+            ROS_WARN("Config: Cannot attach '%s' to '%s', it moves freely", entity.name.c_str(), entity.attachedTo.c_str());
+            continue;
+        }
+
+        m_attachments[entity.name] = attachment;
+    }
+}
+
 std::vector<Entity> Config::entities() const
 {
     return m_entities;
@@ -171,17 +327,30 @@ void Config::dump() const
     std::cout << "Options:\n";
     std::cout << "  loopRate: " << m_options.loopRate << "\n";
     std::cout << "  decayDuration: " << m_options.decayDuration << "\n";
+    std::cout << "  edgeLifetimeFactor: " << m_options.edgeLifetimeFactor << "\n";
+    std::cout << "  maxEdgeLifetime: " << m_options.maxEdgeLifetime << "\n";
+    std::cout << "  edgeHysteresis: " << m_options.edgeHysteresis << "\n";
     std::cout << "  dbgGraphFilename: " << m_options.dbgGraphFilename << "\n";
     std::cout << "  dbgGraphInterval: " << m_options.dbgGraphInterval << "\n";
     std::cout << "  publishMarkers: " << m_options.publishMarkers << "\n";
     std::cout << "  publishWorldSensors: " << m_options.publishWorldSensors << "\n";
     std::cout << "  publishEntitySensors: " << m_options.publishEntitySensors << "\n";
     std::cout << "  publishPoseTopics: " << m_options.publishPoseTopics << "\n";
+    std::cout << "  evalThreads: " << m_options.evalThreads << "\n";
+    std::cout << "  staticTolerance: " << m_options.staticTolerance << "\n";
+    std::cout << "  staticAngleTolerance: " << m_options.staticAngleTolerance << "\n";
+    std::cout << "  evalMode: " << (m_options.evalMode == Options::EvalMode::Optimize ? "Optimize" : "Greedy") << "\n";
+    std::cout << "  solverIterations: " << m_options.solverIterations << "\n";
+    std::cout << "  refineBudget: " << m_options.refineBudget << "\n";
+    std::cout << "  historySize: " << m_options.historySize << "\n";
 
     std::cout << "Entities:\n";
     for (const auto& entity : m_entities)
     {
-        std::cout << "  -" << entity.name << "\n";
+        std::cout << "  -" << entity.name << (entity.isStatic ? " (static)" : "") << "\n";
+
+        if (!entity.attachedTo.empty())
+            std::cout << "    Attached to: " << entity.attachedTo << "\n";
         std::cout << "    Sensors:\n";
 
         for (const auto& sensor : entity.sensors)
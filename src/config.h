@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <map>
 #include <string>
 #include <tf2/LinearMath/Transform.h>
 #include <yaml-cpp/node/node.h>
@@ -75,6 +76,20 @@ struct Entity
     std::vector<Sensor> sensors;
     std::vector<Marker> markers;
     FilterConfig filterConfig;
+    bool isStatic = false; ///< the entity does not move, its pose is frozen once known
+
+    std::string attachedTo; ///< the entity this one is rigidly attached to, empty if it moves freely
+    tf2::Transform attachTransform = tf2::Transform::getIdentity(); ///< the transformation relative to the entity it is attached to
+};
+
+/**
+ * @brief The RigidAttachment struct
+ * Relates a rigidly attached entity to the freely moving entity carrying it
+ */
+struct RigidAttachment
+{
+    std::string carrier; ///< the freely moving entity at the root of the attachment chain
+    tf2::Transform transform = tf2::Transform::getIdentity(); ///< the transformation relative to the carrier
 };
 
 /**
@@ -82,14 +97,35 @@ struct Entity
  */
 struct Options
 {
+    enum class EvalMode
+    {
+        /// Fuses the poses level by level, starting at the world
+        /// (default)
+        Greedy,
+
+        /// Solves the whole graph as a least-squares problem,
+        /// warm started from the previous evaluation
+        Optimize
+    };
+
     std::string dbgGraphFilename; ///< The file to save the graph to
-    double dbgGraphInterval   = 0.0; ///< The graph saving interval in seconds
-    double loopRate           = 60.0; ///< Loop rate of the node in Hz
-    double decayDuration      = 0.25; ///< Decay time of the graph's edges in seconds
-    bool publishMarkers       = true; ///< Publishes the markers via the ros tf system
-    bool publishWorldSensors  = true; ///< Publishes the world sensors via the ros tf system
-    bool publishEntitySensors = true; ///< Publishes the entity sensors via the ros tf system
-    bool publishPoseTopics    = true; ///< Publishes the fused poses as topics of type PoseStamped
+    double dbgGraphInterval     = 0.0; ///< The graph saving interval in seconds
+    double loopRate             = 60.0; ///< Loop rate of the node in Hz
+    double decayDuration        = 0.25; ///< Minimum lifetime of the graph's edges in seconds
+    double edgeLifetimeFactor   = 3.0; ///< Edges expire after this many average message intervals without data
+    double maxEdgeLifetime      = 2.0; ///< Maximum lifetime of the graph's edges in seconds
+    double edgeHysteresis       = 2.0; ///< Lifetime multiplier of the edges of sensors that have been reporting steadily
+    bool publishMarkers         = true; ///< Publishes the markers via the ros tf system
+    bool publishWorldSensors    = true; ///< Publishes the world sensors via the ros tf system
+    bool publishEntitySensors   = true; ///< Publishes the entity sensors via the ros tf system
+    bool publishPoseTopics      = true; ///< Publishes the fused poses as topics of type PoseStamped
+    int evalThreads             = 1; ///< Number of threads used to evaluate the graph
+    double staticTolerance      = 0.05; ///< Deviation in meters that re-arms a frozen static entity
+    double staticAngleTolerance = 5.0; ///< Deviation in degrees that re-arms a frozen static entity
+    EvalMode evalMode           = EvalMode::Greedy; ///< The way the graph is evaluated (see EvalMode)
+    int solverIterations        = 2; ///< Iteration budget of the least-squares solver per evaluation
+    double refineBudget         = 0.0; ///< Time in seconds spent refining the greedy poses per evaluation, 0 disables it
+    int historySize             = 120; ///< Number of evaluated poses kept per entity for past lookups
 };
 
 class Config
@@ -122,6 +158,41 @@ public:
      */
     Options options() const;
 
+    /**
+     * @brief resolveRigid follows the chain of rigid attachments of an entity
+     * @param entity
+     * @return The carrier and the composed transformation, the entity itself and identity if it is not attached
+     */
+    RigidAttachment resolveRigid(const std::string& entity) const;
+
+    /**
+     * @brief attachedEntities
+     * @param carrier
+     * @return The entities rigidly attached to the given one, directly or through other entities
+     */
+    std::vector<std::string> attachedEntities(const std::string& carrier) const;
+
+    /**
+     * @brief entityFromString parses an entity at runtime
+     * @param input: YAML in the format of an item of the 'entities' list
+     * @param entity: Receives the entity if the input is valid
+     * @return False if the input cannot be parsed
+     */
+    bool entityFromString(const std::string& input, Entity& entity) const;
+
+    /**
+     * @brief addEntity adds an entity at runtime, an existing entity with the same name is replaced
+     * @param entity
+     */
+    void addEntity(const Entity& entity);
+
+    /**
+     * @brief removeEntity removes an entity at runtime
+     * @param name
+     * @return False if there is no such entity
+     */
+    bool removeEntity(const std::string& name);
+
     /**
      * @brief dump prints the current configuration
      */
@@ -135,9 +206,22 @@ protected:
      */
     tf2::Transform parseTransform(const YAML::Node& node) const;
 
+    /**
+     * @brief parseEntity creates an entity from a YAML node
+     * @param node contains the YAML node describing an entity
+     * @return the entity
+     */
+    Entity parseEntity(const YAML::Node& node) const;
+
+    /**
+     * @brief resolveAttachments composes the chains of rigid attachments
+     */
+    void resolveAttachments();
+
     void parseRoot(const YAML::Node& node);
 
 private:
     std::vector<Entity> m_entities;
+    std::map<std::string, RigidAttachment> m_attachments;
     Options m_options;
 };
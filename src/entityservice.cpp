@@ -0,0 +1,126 @@
+/*
+ * ATLAS - Cooperative sensing
+ * Copyright (C) 2017  Paul KREMER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "entityservice.h"
+
+#include <algorithm>
+
+EntityService::EntityService(Config& config, SensorListener& listener, TransformGraph& graph, TransformGraphBroadcaster& broadcaster)
+    : m_config(config)
+    , m_listener(listener)
+    , m_graph(graph)
+    , m_broadcaster(broadcaster)
+{
+    m_addService    = m_node.advertiseService("atlas/add_entity", &EntityService::onAddEntity, this);
+    m_removeService = m_node.advertiseService("atlas/remove_entity", &EntityService::onRemoveEntity, this);
+}
+
+bool EntityService::onAddEntity(atlas::AddEntity::Request& req, atlas::AddEntity::Response& res)
+{
+    Entity entity;
+
+    if (!m_config.entityFromString(req.entity, entity) || entity.name == "world")
+    {
+        res.success = false;
+        res.message = "invalid entity";
+        return true;
+    }
+
+    // an entity with the same name is replaced
+    // The graph takes the attachment and the static flag on insertion only,
+    // if they change the entity and the ones attached to it are inserted again.
+    bool reinsert = false;
+
+    for (const auto& previous : m_config.entities())
+    {
+        if (previous.name == entity.name)
+            reinsert = previous.attachedTo != entity.attachedTo || !(previous.attachTransform == entity.attachTransform) || previous.isStatic != entity.isStatic;
+    }
+
+    m_config.addEntity(entity);
+
+    const auto attached = reinsert ? m_config.attachedEntities(entity.name) : std::vector<std::string>();
+
+    if (reinsert)
+    {
+        m_graph.removeEntity(entity.name);
+
+        for (const auto& name : attached)
+            m_graph.removeEntity(name);
+    }
+
+    // the carrier first, the handles of the attached entities might have changed
+    insertEntity(entity);
+
+    for (const auto& other : m_config.entities())
+    {
+        if (std::find(attached.begin(), attached.end(), other.name) != attached.end())
+            insertEntity(other);
+    }
+
+    // the new names are interned on first use
+    m_listener.addEntity(entity);
+
+    ROS_INFO("Added entity \"%s\"", entity.name.c_str());
+
+    res.success = true;
+    return true;
+}
+
+void EntityService::insertEntity(const Entity& entity)
+{
+    const auto attachment = m_config.resolveRigid(entity.name);
+
+    // no effect if the entity is in the graph already
+    if (attachment.carrier != entity.name)
+        m_graph.attachEntity(entity.name, attachment.carrier, attachment.transform);
+    else
+        m_graph.addEntity(entity.name);
+
+    // the flag may have been turned off
+    m_graph.setStatic(entity.name, entity.isStatic);
+
+    m_broadcaster.addEntity(entity);
+}
+
+bool EntityService::onRemoveEntity(atlas::RemoveEntity::Request& req, atlas::RemoveEntity::Response& res)
+{
+    if (req.entity == "world" || !m_graph.hasEntity(req.entity))
+    {
+        res.success = false;
+        res.message = "unknown entity";
+        return true;
+    }
+
+    // the entities attached to the removed one leave along with it, also the ones further down the chain
+    auto names = m_config.attachedEntities(req.entity);
+    names.push_back(req.entity);
+
+    for (const auto& name : names)
+    {
+        m_graph.removeEntity(name);
+        m_listener.removeEntity(name);
+        m_broadcaster.removeEntity(name);
+        m_config.removeEntity(name);
+    }
+
+    ROS_INFO("Removed entity \"%s\"", req.entity.c_str());
+
+    res.success = true;
+    return true;
+}
@@ -0,0 +1,72 @@
+/*
+ * ATLAS - Cooperative sensing
+ * Copyright (C) 2017  Paul KREMER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atlas/AddEntity.h>
+#include <atlas/RemoveEntity.h>
+#include <ros/ros.h>
+
+#include "config.h"
+#include "sensorlistener.h"
+#include "transformgraph.h"
+#include "transformgraphbroadcaster.h"
+
+/**
+ * @brief The EntityService class
+ * Adds and removes entities at runtime, e.g. drones joining and leaving the swarm.
+ * The entity is registered with the graph, the sensor listener and the broadcaster.
+ * The services are handled from the main loop (ros::spinOnce), hence never during an update.
+ */
+class EntityService
+{
+public:
+    EntityService(Config& config, SensorListener& listener, TransformGraph& graph, TransformGraphBroadcaster& broadcaster);
+
+protected:
+    /**
+     * @brief onAddEntity
+     * @param req: The entity as YAML, in the format of an item of the 'entities' list
+     * @param res
+     */
+    bool onAddEntity(atlas::AddEntity::Request& req, atlas::AddEntity::Response& res);
+
+    /**
+     * @brief onRemoveEntity removes the entity and the entities rigidly attached to it
+     * @param req: The name of the entity
+     * @param res
+     */
+    bool onRemoveEntity(atlas::RemoveEntity::Request& req, atlas::RemoveEntity::Response& res);
+
+    /**
+     * @brief insertEntity adds an entity of the config to the graph, attached to its carrier if any,
+     * and publishes it
+     * @param entity
+     */
+    void insertEntity(const Entity& entity);
+
+private:
+    ros::NodeHandle m_node;
+    ros::ServiceServer m_addService;
+    ros::ServiceServer m_removeService;
+
+    Config& m_config;
+    SensorListener& m_listener;
+    TransformGraph& m_graph;
+    TransformGraphBroadcaster& m_broadcaster;
+};
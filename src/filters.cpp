@@ -22,55 +22,95 @@
  * @brief WeightedMean
  */
 
-WeightedMean::WeightedMean()
+template <class T>
+WeightedMeanT<T>::WeightedMeanT()
 {
 }
 
-void WeightedMean::addVec3(const tf2::Vector3& vec, double weight)
+template <class T>
+void WeightedMeanT<T>::addVec3(const tf2::Vector3& vec, double weight)
 {
-    m_vectorWeightedSum += Eigen::Vector3d{ vec.x(), vec.y(), vec.z() } * weight;
+    accumulateVec3(fromTf2<T>(vec), T(weight));
+}
+
+template <class T>
+void WeightedMeanT<T>::addQuat(const tf2::Quaternion& quat, double weight)
+{
+    accumulateQuat(fromTf2<T>(quat).coeffs(), T(weight));
+}
+
+template <class T>
+void WeightedMeanT<T>::addPose(const PoseT<T>& pose, T weight)
+{
+    accumulateVec3(pose.pos, weight);
+    accumulateQuat(pose.rot.coeffs(), weight);
+}
+
+template <class T>
+void WeightedMeanT<T>::accumulateVec3(const Eigen::Matrix<T, 3, 1>& vec, T weight)
+{
+    m_vectorWeightedSum += vec * weight;
     m_vectorWeights += weight;
 }
 
-void WeightedMean::addQuat(const tf2::Quaternion& quat, double weight)
+template <class T>
+void WeightedMeanT<T>::accumulateQuat(const Eigen::Matrix<T, 4, 1>& quat, T weight)
+{
+    // quaternion weighted sum, the coefficients are ordered x, y, z, w
+    const Eigen::Matrix<T, 4, 1> weighted = weight * quat;
+
+    m_quatProducts += weighted * weighted.transpose();
+}
+
+template <class T>
+void WeightedMeanT<T>::reset()
 {
-    // quaternion weighted sum
-    m_quats.conservativeResize(4, m_quats.cols() + 1);
-    m_quats.col(m_quats.cols() - 1) = weight * Eigen::Vector4d{
-        quat.x(),
-        quat.y(),
-        quat.z(),
-        quat.w()
-    };
+    m_vectorWeightedSum.setZero();
+    m_vectorWeights = 0;
+    m_quatProducts.setZero();
 }
 
-void WeightedMean::reset()
+template <class T>
+tf2::Vector3 WeightedMeanT<T>::weightedMeanVec3() const
 {
-    m_vectorWeightedSum = { 0, 0, 0 };
-    m_vectorWeights     = 0.0;
-    m_quats             = Eigen::Matrix4Xd();
+    return toTf2(meanVec3());
 }
 
-tf2::Vector3 WeightedMean::weightedMeanVec3() const
+template <class T>
+tf2::Quaternion WeightedMeanT<T>::weightedMeanQuat() const
 {
-    if (m_vectorWeights == 0.0)
-        return { 0, 0, 0 };
+    const auto eigenvec = meanQuat();
+    return { eigenvec[0], eigenvec[1], eigenvec[2], eigenvec[3] };
+}
 
-    auto average = m_vectorWeightedSum / m_vectorWeights;
-    return { average[0], average[1], average[2] };
+template <class T>
+PoseT<T> WeightedMeanT<T>::weightedMeanPose() const
+{
+    const auto eigenvec = meanQuat();
+    return { meanVec3(), Eigen::Quaternion<T>(eigenvec[3], eigenvec[0], eigenvec[1], eigenvec[2]) };
 }
 
-tf2::Quaternion WeightedMean::weightedMeanQuat() const
+template <class T>
+Eigen::Matrix<T, 3, 1> WeightedMeanT<T>::meanVec3() const
+{
+    if (m_vectorWeights == T(0))
+        return Eigen::Matrix<T, 3, 1>::Zero();
+
+    return m_vectorWeightedSum / m_vectorWeights;
+}
+
+template <class T>
+Eigen::Matrix<T, 4, 1> WeightedMeanT<T>::meanQuat() const
 {
     // quaternion interpolation matrix
     // calculations based on http://www.acsu.buffalo.edu/~johnc/ave_quat07.pdf
 
     // solve the eigenproblem
-    Eigen::SelfAdjointEigenSolver<Eigen::Matrix4Xd> solver(m_quats * m_quats.transpose());
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix<T, 4, 4>> solver(m_quatProducts);
 
     // find largest eigenvalue
-    int index     = 0;
-    double maxVal = -1.0;
+    int index = 0;
+    T maxVal  = -1;
 
     for (int i = 0; i < solver.eigenvalues().rows(); ++i)
     {
@@ -83,111 +123,123 @@ tf2::Quaternion WeightedMean::weightedMeanQuat() const
 
     // the eigenvector corresponding to the largest eigenvalue
     // is the weighted average of the quaternion
-    auto eigenvec = solver.eigenvectors().col(index);
-    return { eigenvec[0], eigenvec[1], eigenvec[2], eigenvec[3] };
+    return solver.eigenvectors().col(index);
 }
 
 /**
  * @brief ExplonentialMovingAverage
  */
 
-ExplonentialMovingAverageFilter::ExplonentialMovingAverageFilter()
+template <class T>
+ExplonentialMovingAverageFilterT<T>::ExplonentialMovingAverageFilterT()
 {
 }
 
-ExplonentialMovingAverageFilter::ExplonentialMovingAverageFilter(double alpha, ros::Duration timeout)
-    : m_alpha(alpha)
+template <class T>
+ExplonentialMovingAverageFilterT<T>::ExplonentialMovingAverageFilterT(double alpha, ros::Duration timeout)
+    : m_alpha(T(alpha))
     , m_timeout(timeout)
 {
 }
 
-void ExplonentialMovingAverageFilter::addScalar(double scalar)
+template <class T>
+void ExplonentialMovingAverageFilterT<T>::addScalar(double scalar)
 {
     checkReinit();
     if (m_scalarInitialized)
     {
-        m_scalarAccu = (m_alpha * scalar) + (1.0 - m_alpha) * m_scalarAccu;
+        m_scalarAccu = (m_alpha * T(scalar)) + (T(1) - m_alpha) * m_scalarAccu;
     }
     else
     {
-        m_scalarAccu        = scalar;
+        m_scalarAccu        = T(scalar);
         m_scalarInitialized = true;
     }
 
     m_timeOfLastValue = ros::Time::now();
 }
 
-void ExplonentialMovingAverageFilter::addVec3(const tf2::Vector3& vec)
+template <class T>
+void ExplonentialMovingAverageFilterT<T>::addVec3(const tf2::Vector3& vec)
 {
     checkReinit();
     if (m_vecInitialized)
     {
-        m_vectorAccu = (m_alpha * vec) + (1.0 - m_alpha) * m_vectorAccu;
+        m_vectorAccu = (m_alpha * fromTf2<T>(vec)) + (T(1) - m_alpha) * m_vectorAccu;
     }
     else
     {
-        m_vectorAccu     = vec;
+        m_vectorAccu     = fromTf2<T>(vec);
         m_vecInitialized = true;
     }
 
     m_timeOfLastValue = ros::Time::now();
 }
 
-void ExplonentialMovingAverageFilter::addQuat(const tf2::Quaternion& quat)
+template <class T>
+void ExplonentialMovingAverageFilterT<T>::addQuat(const tf2::Quaternion& quat)
 {
     checkReinit();
     if (m_quatInitialized)
     {
-        m_quatAccu = m_quatAccu.slerp(quat, m_alpha);
+        m_quatAccu = m_quatAccu.slerp(m_alpha, fromTf2<T>(quat));
     }
     else
     {
-        m_quatAccu        = quat;
+        m_quatAccu        = fromTf2<T>(quat);
         m_quatInitialized = true;
     }
 
     m_timeOfLastValue = ros::Time::now();
 }
 
-void ExplonentialMovingAverageFilter::addPose(const Pose& pose)
+template <class T>
+void ExplonentialMovingAverageFilterT<T>::addPose(const Pose& pose)
 {
     addVec3(pose.pos);
     addQuat(pose.rot);
 }
 
-void ExplonentialMovingAverageFilter::reset()
+template <class T>
+void ExplonentialMovingAverageFilterT<T>::reset()
 {
     m_scalarInitialized = false;
     m_quatInitialized   = false;
     m_vecInitialized    = false;
 }
 
-double ExplonentialMovingAverageFilter::scalar() const
+template <class T>
+double ExplonentialMovingAverageFilterT<T>::scalar() const
 {
     return m_scalarAccu;
 }
 
-tf2::Vector3 ExplonentialMovingAverageFilter::vec3() const
+template <class T>
+tf2::Vector3 ExplonentialMovingAverageFilterT<T>::vec3() const
 {
-    return m_vectorAccu;
+    return toTf2(m_vectorAccu);
 }
 
-tf2::Quaternion ExplonentialMovingAverageFilter::quat() const
+template <class T>
+tf2::Quaternion ExplonentialMovingAverageFilterT<T>::quat() const
 {
-    return m_quatAccu;
+    return toTf2(m_quatAccu);
 }
 
-Pose ExplonentialMovingAverageFilter::pose() const
+template <class T>
+Pose ExplonentialMovingAverageFilterT<T>::pose() const
 {
     return Pose(vec3(), quat());
 }
 
-ros::Time ExplonentialMovingAverageFilter::timeOfLastValue() const
+template <class T>
+ros::Time ExplonentialMovingAverageFilterT<T>::timeOfLastValue() const
 {
     return m_timeOfLastValue;
 }
 
-void ExplonentialMovingAverageFilter::checkReinit()
+template <class T>
+void ExplonentialMovingAverageFilterT<T>::checkReinit()
 {
     if (m_timeout.toSec() == 0.0)
         return;
@@ -196,17 +248,26 @@ void ExplonentialMovingAverageFilter::checkReinit()
         reset();
 }
 
-void ExplonentialMovingAverageFilter::setAlpha(double alpha)
+template <class T>
+void ExplonentialMovingAverageFilterT<T>::setAlpha(double alpha)
 {
-    m_alpha = alpha;
+    m_alpha = T(alpha);
 }
 
-double ExplonentialMovingAverageFilter::alpha() const
+template <class T>
+double ExplonentialMovingAverageFilterT<T>::alpha() const
 {
     return m_alpha;
 }
 
-void ExplonentialMovingAverageFilter::setTimeout(const ros::Duration& timeout)
+template <class T>
+void ExplonentialMovingAverageFilterT<T>::setTimeout(const ros::Duration& timeout)
 {
     m_timeout = timeout;
 }
+
+// the fusion core is built in both precisions
+template class WeightedMeanT<float>;
+template class WeightedMeanT<double>;
+template class ExplonentialMovingAverageFilterT<float>;
+template class ExplonentialMovingAverageFilterT<double>;
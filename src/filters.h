@@ -28,18 +28,21 @@
 #include "helpers.h"
 
 /**
- * @brief The WeightedMean class
+ * @brief The WeightedMeanT class
+ * Accumulates in the given precision, tf2 is converted on the way in and out
  */
-class WeightedMean
+template <class T>
+class WeightedMeanT
 {
 public:
     /**
-     * @brief WeightedMean
+     * @brief WeightedMeanT
      */
-    WeightedMean();
+    WeightedMeanT();
 
     void addVec3(const tf2::Vector3& vec, double weight);
     void addQuat(const tf2::Quaternion& quat, double weight);
+    void addPose(const PoseT<T>& pose, T weight);
     void reset();
 
     /**
@@ -54,30 +57,49 @@ public:
      */
     tf2::Quaternion weightedMeanQuat() const;
 
+    /**
+     * @brief weightedMeanPose
+     * @return The weighted mean of all vectors and quaternions
+     */
+    PoseT<T> weightedMeanPose() const;
+
+protected:
+    void accumulateVec3(const Eigen::Matrix<T, 3, 1>& vec, T weight);
+    void accumulateQuat(const Eigen::Matrix<T, 4, 1>& quat, T weight);
+    Eigen::Matrix<T, 3, 1> meanVec3() const;
+    Eigen::Matrix<T, 4, 1> meanQuat() const;
+
 private:
-    Eigen::Vector3d m_vectorWeightedSum = { 0, 0, 0 };
-    Eigen::Matrix4Xd m_quats;
+    Eigen::Matrix<T, 3, 1, Eigen::DontAlign> m_vectorWeightedSum = Eigen::Matrix<T, 3, 1>::Zero();
+
+    // the sum of the outer products of the weighted quaternions
+    // Fixed size, hence no allocations. Unaligned, such that it can be stored anywhere.
+    Eigen::Matrix<T, 4, 4, Eigen::DontAlign> m_quatProducts = Eigen::Matrix<T, 4, 4>::Zero();
 
-    double m_vectorWeights = 0.0;
+    T m_vectorWeights = 0;
 };
 
+using WeightedMean = WeightedMeanT<FusionScalar>;
+
 /**
- * @brief The ExplonentialMovingAverage class
+ * @brief The ExplonentialMovingAverageFilterT class
+ * Filters in the given precision, tf2 is converted on the way in and out
  */
-class ExplonentialMovingAverageFilter
+template <class T>
+class ExplonentialMovingAverageFilterT
 {
 public:
     /**
      * @brief ExplonentialMovingAverage
      */
-    ExplonentialMovingAverageFilter();
+    ExplonentialMovingAverageFilterT();
 
     /**
      * @brief ExplonentialMovingAverage
      * @param alpha is the exponential factor. Lower alpha means slower filter (or higher time constant).
      * @param timeout tells the filter to reinitialize after a given amount of time without data
      */
-    explicit ExplonentialMovingAverageFilter(double alpha, ros::Duration timeout = ros::Duration(0));
+    explicit ExplonentialMovingAverageFilterT(double alpha, ros::Duration timeout = ros::Duration(0));
 
     /**
      * @brief addScalar
@@ -162,12 +184,12 @@ protected:
     void checkReinit();
 
 private:
-    double m_alpha = 0.05; // exponential constant
+    T m_alpha = T(0.05); // exponential constant
 
     // the accumulators
-    double m_scalarAccu        = 0.0;
-    tf2::Vector3 m_vectorAccu  = { 0, 0, 0 };
-    tf2::Quaternion m_quatAccu = tf2::Quaternion::getIdentity();
+    T m_scalarAccu                                        = 0;
+    Eigen::Matrix<T, 3, 1, Eigen::DontAlign> m_vectorAccu = Eigen::Matrix<T, 3, 1>::Zero();
+    Eigen::Quaternion<T, Eigen::DontAlign> m_quatAccu     = Eigen::Quaternion<T>::Identity();
 
     // we keep track of the time of the last value
     // in order to reset the filter if it's too old
@@ -178,3 +200,5 @@ private:
     bool m_quatInitialized   = false;
     ros::Duration m_timeout;
 };
+
+using ExplonentialMovingAverageFilter = ExplonentialMovingAverageFilterT<FusionScalar>;
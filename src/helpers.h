@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <eigen3/Eigen/Geometry>
 #include <tf2/LinearMath/Quaternion.h>
 #include <tf2/LinearMath/Transform.h>
 #include <tf2/LinearMath/Vector3.h>
@@ -27,6 +28,13 @@
 
 #define UNUSED(x) (void)(x);
 
+// the precision of the fusion core, tf2 (i.e. double) is used at the ROS boundary
+#ifdef ATLAS_FLOAT
+using FusionScalar = float;
+#else
+using FusionScalar = double;
+#endif
+
 // tf2 print helpers
 namespace tf2
 {
@@ -50,6 +58,94 @@ struct Pose
 
 std::ostream& operator<<(std::ostream& os, const Pose& pose);
 
+/**
+ * @brief The PoseT struct
+ * A pose stored in the given precision, also used as a rigid transformation.
+ * Composed as quaternion and translation using Eigen's fixed-size (SIMD) kernels, no rotation matrices involved.
+ * Unaligned, such that it can be stored anywhere.
+ */
+template <class T>
+struct PoseT
+{
+    using Vector3    = Eigen::Matrix<T, 3, 1, Eigen::DontAlign>;
+    using Quaternion = Eigen::Quaternion<T, Eigen::DontAlign>;
+
+    PoseT() {}
+    PoseT(const Vector3& pos, const Quaternion& rot)
+        : pos(pos)
+        , rot(rot)
+    {
+    }
+
+    explicit PoseT(const Pose& pose)
+        : pos(T(pose.pos.x()), T(pose.pos.y()), T(pose.pos.z()))
+        , rot(T(pose.rot.w()), T(pose.rot.x()), T(pose.rot.y()), T(pose.rot.z()))
+    {
+    }
+
+    explicit PoseT(const tf2::Transform& transform)
+        : PoseT(Pose(transform.getOrigin(), transform.getRotation()))
+    {
+    }
+
+    /**
+     * @brief operator * composes two transformations, i.e. the other one is applied in the frame of this one
+     * @param other
+     * @return The composed transformation
+     */
+    PoseT operator*(const PoseT& other) const
+    {
+        return { pos + rot * other.pos, rot * other.rot };
+    }
+
+    /**
+     * @brief toPose
+     * @return The pose as used at the ROS boundary
+     */
+    Pose toPose() const
+    {
+        return { { pos.x(), pos.y(), pos.z() }, { rot.x(), rot.y(), rot.z(), rot.w() } };
+    }
+
+    /**
+     * @brief toTransform
+     * @return The transformation as used at the ROS boundary
+     */
+    tf2::Transform toTransform() const
+    {
+        const auto pose = toPose();
+        return tf2::Transform(pose.rot, pose.pos);
+    }
+
+    Vector3 pos    = Vector3::Zero();
+    Quaternion rot = Quaternion::Identity();
+};
+
+// conversions between tf2 and the fusion core
+template <class T>
+Eigen::Matrix<T, 3, 1> fromTf2(const tf2::Vector3& vec)
+{
+    return { T(vec.x()), T(vec.y()), T(vec.z()) };
+}
+
+template <class T>
+Eigen::Quaternion<T> fromTf2(const tf2::Quaternion& quat)
+{
+    return { T(quat.w()), T(quat.x()), T(quat.y()), T(quat.z()) };
+}
+
+template <class Derived>
+tf2::Vector3 toTf2(const Eigen::MatrixBase<Derived>& vec)
+{
+    return { double(vec.x()), double(vec.y()), double(vec.z()) };
+}
+
+template <class Derived>
+tf2::Quaternion toTf2(const Eigen::QuaternionBase<Derived>& quat)
+{
+    return { double(quat.x()), double(quat.y()), double(quat.z()), double(quat.w()) };
+}
+
 inline bool hasNanValues(const tf2::Vector3& pos)
 {
     return isnan(pos.x()) || isnan(pos.y()) || isnan(pos.z());
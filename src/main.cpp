@@ -19,7 +19,9 @@
 #include <ros/ros.h>
 
 #include "config.h"
+#include "entityservice.h"
 #include "sensorlistener.h"
+#include "symbols.h"
 #include "transformgraph.h"
 #include "transformgraphbroadcaster.h"
 
@@ -40,11 +42,17 @@ int main(int argc, char** argv)
     // print the config
     config.dump();
 
+    // intern the names used on the hot path
+    SymbolTable::instance().populate(config);
+
     // init the rest
     SensorListener sensorListener(config);
     TransformGraph graph(config);
     TransformGraphBroadcaster broadcaster(config);
 
+    // entities joining and leaving at runtime
+    EntityService entityService(config, sensorListener, graph, broadcaster);
+
     //////////////////////////////////////
     ///      Main Loop
     //////////////////////////////////////
@@ -0,0 +1,217 @@
+/*
+ * ATLAS - Cooperative sensing
+ * Copyright (C) 2017  Paul KREMER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "posegraphsolver.h"
+
+namespace
+{
+using Matrix6d = Eigen::Matrix<double, 6, 6>;
+using Vector6d = Eigen::Matrix<double, 6, 1>;
+
+Eigen::Vector3d toEigen(const tf2::Vector3& vec)
+{
+    return { vec.x(), vec.y(), vec.z() };
+}
+
+Eigen::Matrix3d toEigen(const tf2::Quaternion& quat)
+{
+    return Eigen::Quaterniond(quat.w(), quat.x(), quat.y(), quat.z()).toRotationMatrix();
+}
+
+Eigen::Matrix3d skew(const Eigen::Vector3d& vec)
+{
+    Eigen::Matrix3d mat;
+    mat << 0, -vec.z(), vec.y(),
+        vec.z(), 0, -vec.x(),
+        -vec.y(), vec.x(), 0;
+    return mat;
+}
+
+// the rotation vector (axis * angle) of a rotation matrix
+Eigen::Vector3d logMap(const Eigen::Matrix3d& rot)
+{
+    const Eigen::AngleAxisd angleAxis(rot);
+    return angleAxis.angle() * angleAxis.axis();
+}
+
+// the quaternion of a rotation vector
+tf2::Quaternion expMap(const Eigen::Vector3d& vec)
+{
+    const double angle = vec.norm();
+
+    if (angle < 1e-12)
+        return tf2::Quaternion::getIdentity();
+
+    return tf2::Quaternion({ vec.x() / angle, vec.y() / angle, vec.z() / angle }, angle);
+}
+
+// adds a 6x6 block to the triplets of a sparse matrix
+void addBlock(std::vector<Eigen::Triplet<double>>& triplets, int row, int col, const Matrix6d& block)
+{
+    for (int r = 0; r < 6; ++r)
+    {
+        for (int c = 0; c < 6; ++c)
+            triplets.emplace_back(row + r, col + c, block(r, c));
+    }
+}
+}
+
+void PoseGraphSolver::clear()
+{
+    m_poses.clear();
+    m_columns.clear();
+    m_constraints.clear();
+    m_dimension = 0;
+}
+
+int PoseGraphSolver::addPose(const Pose& initial, bool fixed)
+{
+    m_poses.push_back(initial);
+    m_columns.push_back(fixed ? -1 : m_dimension);
+
+    if (!fixed)
+        m_dimension += 6;
+
+    return int(m_poses.size() - 1);
+}
+
+void PoseGraphSolver::addConstraint(const Constraint& constraint)
+{
+    // constraints between fixed poses have no effect
+    if (m_columns[constraint.source] == -1 && m_columns[constraint.target] == -1)
+        return;
+
+    m_constraints.push_back(constraint);
+}
+
+int PoseGraphSolver::solve(int maxIterations)
+{
+    if (m_dimension == 0)
+        return 0;
+
+    m_hessian.resize(m_dimension, m_dimension);
+    m_gradient.resize(m_dimension);
+
+    for (int i = 0; i < maxIterations; ++i)
+    {
+        const double update = iterate();
+
+        if (update < 0.0)
+            return -1;
+
+        // warm started solves usually stop here after one or two iterations
+        if (update < m_tolerance)
+            return i + 1;
+    }
+
+    return maxIterations;
+}
+
+const Pose& PoseGraphSolver::pose(int index) const
+{
+    return m_poses[index];
+}
+
+std::size_t PoseGraphSolver::numberOfPoses() const
+{
+    return m_poses.size();
+}
+
+double PoseGraphSolver::iterate()
+{
+    // The residual of a constraint from i to j with the measurement (Rz, tz) is
+    //   r_t = Ri^T (tj - ti) - tz
+    //   r_R = log(Rz^T Ri^T Rj)
+    // The positions are updated in the world frame, the rotations in their local frame.
+    // The residuals are small close to the solution, the jacobian of the rotation log
+    // is approximated by the identity.
+    m_triplets.clear();
+    m_gradient.setZero();
+
+    for (const auto& constraint : m_constraints)
+    {
+        const auto& source = m_poses[constraint.source];
+        const auto& target = m_poses[constraint.target];
+
+        const Eigen::Matrix3d Ri = toEigen(source.rot);
+        const Eigen::Matrix3d Rj = toEigen(target.rot);
+        const Eigen::Matrix3d Rz = toEigen(constraint.transform.getRotation());
+        const Eigen::Vector3d d  = Ri.transpose() * (toEigen(target.pos) - toEigen(source.pos));
+
+        Vector6d residual;
+        residual.head<3>() = d - toEigen(constraint.transform.getOrigin());
+        residual.tail<3>() = logMap(Rz.transpose() * Ri.transpose() * Rj);
+
+        Matrix6d Ji = Matrix6d::Zero();
+        Ji.block<3, 3>(0, 0) = -Ri.transpose();
+        Ji.block<3, 3>(0, 3) = skew(d);
+        Ji.block<3, 3>(3, 3) = -Rj.transpose() * Ri;
+
+        Matrix6d Jj = Matrix6d::Zero();
+        Jj.block<3, 3>(0, 0) = Ri.transpose();
+        Jj.block<3, 3>(3, 3) = Eigen::Matrix3d::Identity();
+
+        // sigma as information
+        const double information = 1.0 / (constraint.sigma * constraint.sigma);
+
+        const int i = m_columns[constraint.source];
+        const int j = m_columns[constraint.target];
+
+        if (i != -1)
+        {
+            addBlock(m_triplets, i, i, information * Ji.transpose() * Ji);
+            m_gradient.segment<6>(i) += information * Ji.transpose() * residual;
+        }
+
+        if (j != -1)
+        {
+            addBlock(m_triplets, j, j, information * Jj.transpose() * Jj);
+            m_gradient.segment<6>(j) += information * Jj.transpose() * residual;
+        }
+
+        if (i != -1 && j != -1)
+        {
+            addBlock(m_triplets, i, j, information * Ji.transpose() * Jj);
+            addBlock(m_triplets, j, i, information * Jj.transpose() * Ji);
+        }
+    }
+
+    // duplicates are summed up
+    m_hessian.setFromTriplets(m_triplets.begin(), m_triplets.end());
+    m_ldlt.compute(m_hessian);
+
+    if (m_ldlt.info() != Eigen::Success)
+        return -1.0;
+
+    const Eigen::VectorXd delta = m_ldlt.solve(-m_gradient);
+
+    // apply the update
+    for (std::size_t p = 0; p < m_poses.size(); ++p)
+    {
+        const int col = m_columns[p];
+
+        if (col == -1)
+            continue;
+
+        auto& pose = m_poses[p];
+        pose.pos += tf2::Vector3(delta[col], delta[col + 1], delta[col + 2]);
+        pose.rot = (pose.rot * expMap(delta.segment<3>(col + 3))).normalized();
+    }
+
+    return delta.lpNorm<Eigen::Infinity>();
+}
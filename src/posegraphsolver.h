@@ -0,0 +1,112 @@
+/*
+ * ATLAS - Cooperative sensing
+ * Copyright (C) 2017  Paul KREMER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <eigen3/Eigen/Geometry>
+#include <eigen3/Eigen/Sparse>
+#include <tf2/LinearMath/Transform.h>
+
+#include <vector>
+
+#include "helpers.h"
+
+/**
+ * @brief The PoseGraphSolver class
+ * Solves a pose graph as a sparse nonlinear least-squares problem using Gauss-Newton iterations.
+ * The poses are the variables, the relative measurements between them the constraints.
+ * Each constraint is weighted by the inverse of its variance.
+ * The buffers are kept between the solves, no allocations take place once the problem size is stable.
+ */
+class PoseGraphSolver
+{
+public:
+    /**
+     * @brief The Constraint struct
+     * A relative measurement between two poses
+     */
+    struct Constraint
+    {
+        int source = -1; ///< the pose the measurement is taken from
+        int target = -1; ///< the measured pose
+        tf2::Transform transform; ///< the pose of the target in the frame of the source
+        double sigma = 1.0; ///< the standard deviation of the measurement
+    };
+
+    /**
+     * @brief clear removes all poses and constraints
+     */
+    void clear();
+
+    /**
+     * @brief addPose adds a variable to the problem
+     * @param initial: The initial guess, e.g. the solution of the previous solve
+     * @param fixed: Fixed poses anchor the problem and are not optimized
+     * @return The index of the pose
+     */
+    int addPose(const Pose& initial, bool fixed);
+
+    /**
+     * @brief addConstraint adds a relative measurement between two poses
+     * @param constraint
+     */
+    void addConstraint(const Constraint& constraint);
+
+    /**
+     * @brief solve refines the poses until they converged or the iteration budget is used up.
+     * Every connected part of the problem has to contain a fixed pose.
+     * @param maxIterations
+     * @return The number of iterations, -1 if the problem is ill-posed
+     */
+    int solve(int maxIterations);
+
+    /**
+     * @brief pose
+     * @param index
+     * @return The current estimate of a pose
+     */
+    const Pose& pose(int index) const;
+
+    /**
+     * @brief numberOfPoses
+     * @return The number of poses, fixed or not
+     */
+    std::size_t numberOfPoses() const;
+
+protected:
+    /**
+     * @brief iterate runs a single Gauss-Newton iteration
+     * @return The largest update, negative if the system could not be solved
+     */
+    double iterate();
+
+private:
+    std::vector<Pose> m_poses;
+    std::vector<int> m_columns; ///< the first column of each pose in the linear system, -1 if fixed
+    std::vector<Constraint> m_constraints;
+    int m_dimension = 0; ///< the number of unknowns i.e. 6 per free pose
+
+    // the normal equations, reused between the iterations
+    std::vector<Eigen::Triplet<double>> m_triplets;
+    Eigen::SparseMatrix<double> m_hessian;
+    Eigen::VectorXd m_gradient;
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> m_ldlt;
+
+    // updates below the tolerance count as converged
+    double m_tolerance = 1e-9;
+};
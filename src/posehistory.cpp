@@ -0,0 +1,132 @@
+/*
+ * ATLAS - Cooperative sensing
+ * Copyright (C) 2017  Paul KREMER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "posehistory.h"
+
+PoseHistory::PoseHistory(std::size_t capacity)
+    : m_entries(capacity)
+{
+}
+
+void PoseHistory::push(const ros::Time& stamp, const Pose& pose)
+{
+    if (m_size > 0 && stamp <= entry(m_size - 1).stamp)
+        return;
+
+    Entry item;
+    item.stamp = stamp;
+    item.pose  = PoseT<FusionScalar>(pose);
+    item.valid = true;
+
+    append(item);
+}
+
+void PoseHistory::pushGap(const ros::Time& stamp)
+{
+    // a single entry marks the whole gap
+    if (m_size == 0 || !entry(m_size - 1).valid || stamp <= entry(m_size - 1).stamp)
+        return;
+
+    Entry item;
+    item.stamp = stamp;
+
+    append(item);
+}
+
+bool PoseHistory::lookup(const ros::Time& time, Pose& pose) const
+{
+    if (m_size == 0 || time < entry(0).stamp || time > entry(m_size - 1).stamp)
+        return false;
+
+    // binary search for the first entry not older than the given time
+    std::size_t first = 0;
+    std::size_t count = m_size;
+
+    while (count > 0)
+    {
+        const auto step = count / 2;
+
+        if (entry(first + step).stamp < time)
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    const auto& after = entry(first);
+
+    if (after.stamp == time)
+    {
+        pose = after.pose.toPose();
+        return after.valid;
+    }
+
+    // the time is within the range, the entry before exists
+    const auto& before = entry(first - 1);
+
+    if (!before.valid || !after.valid)
+        return false;
+
+    const auto t = FusionScalar((time - before.stamp).toSec() / (after.stamp - before.stamp).toSec());
+
+    PoseT<FusionScalar> interpolated;
+    interpolated.pos = before.pose.pos + t * (after.pose.pos - before.pose.pos);
+    interpolated.rot = before.pose.rot.slerp(t, after.pose.rot);
+
+    pose = interpolated.toPose();
+
+    return true;
+}
+
+std::size_t PoseHistory::size() const
+{
+    return m_size;
+}
+
+void PoseHistory::clear()
+{
+    m_begin = 0;
+    m_size  = 0;
+}
+
+const PoseHistory::Entry& PoseHistory::entry(std::size_t index) const
+{
+    return m_entries[(m_begin + index) % m_entries.size()];
+}
+
+void PoseHistory::append(const Entry& entry)
+{
+    if (m_entries.empty())
+        return;
+
+    if (m_size < m_entries.size())
+    {
+        m_entries[(m_begin + m_size) % m_entries.size()] = entry;
+        m_size++;
+    }
+    else
+    {
+        // overwrite the oldest entry
+        m_entries[m_begin] = entry;
+        m_begin            = (m_begin + 1) % m_entries.size();
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ * ATLAS - Cooperative sensing
+ * Copyright (C) 2017  Paul KREMER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <ros/time.h>
+
+#include <vector>
+
+#include "helpers.h"
+
+/**
+ * @brief The PoseHistory class
+ * A fixed-capacity ring buffer of timestamped poses.
+ * The storage is allocated upfront, the oldest pose is overwritten once the buffer is full.
+ * The poses are stored in the precision of the fusion core.
+ */
+class PoseHistory
+{
+public:
+    /**
+     * @brief PoseHistory
+     * @param capacity: The number of poses kept
+     */
+    explicit PoseHistory(std::size_t capacity = 0);
+
+    /**
+     * @brief push appends a pose. Poses not newer than the latest one are ignored.
+     * @param stamp
+     * @param pose
+     */
+    void push(const ros::Time& stamp, const Pose& pose);
+
+    /**
+     * @brief pushGap marks that there is no pose from the given time on, e.g. the entity lost its connection.
+     * Lookups do not interpolate across a gap.
+     * @param stamp
+     */
+    void pushGap(const ros::Time& stamp);
+
+    /**
+     * @brief lookup interpolates the pose at a given time (linear for the position, spherical for the rotation)
+     * @param time
+     * @param pose: Receives the pose if the lookup is successful
+     * @return False if the time is not covered by the history
+     */
+    bool lookup(const ros::Time& time, Pose& pose) const;
+
+    /**
+     * @brief size
+     * @return The number of stored entries
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief clear removes all the entries, the storage is kept
+     */
+    void clear();
+
+protected:
+    struct Entry
+    {
+        ros::Time stamp;
+        PoseT<FusionScalar> pose;
+        bool valid = false; ///< false if the entry marks a gap
+    };
+
+    /**
+     * @brief entry
+     * @param index: 0 is the oldest entry
+     * @return The entry at the given index
+     */
+    const Entry& entry(std::size_t index) const;
+
+    /**
+     * @brief append stores an entry, overwriting the oldest one if the buffer is full
+     * @param entry
+     */
+    void append(const Entry& entry);
+
+private:
+    std::vector<Entry> m_entries;
+    std::size_t m_begin = 0; ///< the slot of the oldest entry
+    std::size_t m_size  = 0;
+};
@@ -28,33 +28,80 @@ SensorListener::SensorListener()
 }
 
 SensorListener::SensorListener(const Config& config)
+    : m_filterTimeout(config.options().decayDuration)
 {
     // setup marker sensor listeners
     for (const auto& entity : config.entities())
+        addEntity(entity);
+}
+
+void SensorListener::addEntity(const Entity& entity)
+{
+    // replace the previous subscriptions
+    removeEntity(entity.name);
+
+    // the sensors targeting the entity resume
+    m_removedEntities.erase(Symbol(entity.name));
+
+    auto& subscriptions = m_entities[entity.name];
+
+    // The data is keyed by the entity it belongs to, rigidly attached or not.
+    // The graph folds the data of attached entities into their carriers,
+    // such that it can be told apart once an attached entity leaves.
+    for (const auto& sensor : entity.sensors)
     {
-        for (const auto& sensor : entity.sensors)
+        switch (sensor.type)
         {
-            switch (sensor.type)
-            {
-            case Sensor::Type::MarkerBased:
-                setupMarkerBasedSensor(entity, sensor);
-                break;
-            case Sensor::Type::NonMarkerBased:
-                setupNonMarkerBasedSensor(entity, sensor);
-                break;
-            }
+        case Sensor::Type::MarkerBased:
+            subscriptions.subscribers.push_back(setupMarkerBasedSensor(entity.name, sensor));
+            break;
+        case Sensor::Type::NonMarkerBased:
+            subscriptions.subscribers.push_back(setupNonMarkerBasedSensor(entity.name, sensor));
+            break;
         }
+    }
 
-        // setup markers
-        // contains the information to map a marker to an entity
-        for (const auto& marker : entity.markers)
-        {
-            m_markers[marker.id] = { entity.name, marker };
-        }
+    // setup markers
+    // contains the information to map a marker to an entity
+    for (const auto& marker : entity.markers)
+    {
+        m_markers[marker.id] = { Symbol(entity.name), marker };
+        subscriptions.markers.push_back(marker.id);
     }
 }
 
-void SensorListener::onSensorDataAvailable(const std::string& from, const std::string& to, const std::string& sensor, const tf2::Transform& sensorTransform, const tf2::Transform& entityMarkerTransform, const atlas::MarkerData& markerMsg)
+void SensorListener::removeEntity(const std::string& name)
+{
+    auto itr = m_entities.find(name);
+
+    if (itr == m_entities.end())
+        return;
+
+    // the sensors of other entities targeting it are suspended (e.g. a world-mounted tracker)
+    m_removedEntities.insert(Symbol(name));
+
+    // no more callbacks from its topics
+    for (auto& subscriber : itr->second.subscribers)
+        subscriber.shutdown();
+
+    for (auto marker : itr->second.markers)
+        m_markers.erase(marker);
+
+    m_entities.erase(itr);
+
+    // drop the data received since the last update
+    const auto symbol = Symbol(name);
+
+    for (auto data = m_rawSensorData.begin(); data != m_rawSensorData.end();)
+    {
+        if (data->first.from == symbol || data->first.to == symbol)
+            data = m_rawSensorData.erase(data);
+        else
+            ++data;
+    }
+}
+
+void SensorListener::onSensorDataAvailable(Symbol from, Symbol to, Symbol sensor, const tf2::Transform& sensorTransform, const tf2::Transform& entityMarkerTransform, const atlas::MarkerData& markerMsg)
 {
     // store the transformation of the marker in the sensor space
     tf2::Transform markerTransf;
@@ -76,7 +123,7 @@ void SensorListener::onSensorDataAvailable(const std::string& from, const std::s
 
     // filter
     // setup
-    m_rawSensorData[measurement.key].setTimeout(ros::Duration(0.25));
+    m_rawSensorData[measurement.key].setTimeout(m_filterTimeout);
 
     // add the new data to the filter
     m_rawSensorData[measurement.key].addQuat(measurement.transform.getRotation());
@@ -84,13 +131,13 @@ void SensorListener::onSensorDataAvailable(const std::string& from, const std::s
     m_rawSensorData[measurement.key].addScalar(measurement.sigma);
 }
 
-void SensorListener::setupMarkerBasedSensor(const Entity& entity, const Sensor& sensor)
+ros::Subscriber SensorListener::setupMarkerBasedSensor(const std::string& entity, const Sensor& sensor)
 {
     using SensorCallback = void(atlas::MarkerDataConstPtr);
 
     // data passed to the callback lambda
-    auto from       = entity.name;
-    auto sensorName = sensor.name;
+    auto from       = Symbol(entity);
+    auto sensorName = Symbol(sensor.name);
     auto transform  = sensor.transf;
 
     // callback lambda function
@@ -100,8 +147,8 @@ void SensorListener::setupMarkerBasedSensor(const Entity& entity, const Sensor&
         auto keyvalItr = m_markers.find(markerData->id);
         if (keyvalItr != m_markers.end())
         {
-            const auto to                    = keyvalItr->second.first;
-            const auto entityMarkerTransform = keyvalItr->second.second.transf;
+            const auto& to                    = keyvalItr->second.first;
+            const auto& entityMarkerTransform = keyvalItr->second.second.transf;
 
             onSensorDataAvailable(from, to, sensorName, transform, entityMarkerTransform, *markerData);
         }
@@ -112,19 +159,18 @@ void SensorListener::setupMarkerBasedSensor(const Entity& entity, const Sensor&
     };
 
     // tell ros we want to listen to that topic
-    m_subscribers.push_back(m_node.subscribe<SensorCallback>(sensor.topic, 1000, callbackSensor));
     ROS_INFO("Suscribed to topic \"%s\"", sensor.topic.c_str());
+    return m_node.subscribe<SensorCallback>(sensor.topic, 1000, callbackSensor);
 }
 
-void SensorListener::setupNonMarkerBasedSensor(const Entity& entity, const Sensor& sensor)
+ros::Subscriber SensorListener::setupNonMarkerBasedSensor(const std::string& entity, const Sensor& sensor)
 {
-    UNUSED(entity);
     using SensorCallback = void(geometry_msgs::PoseStampedConstPtr);
 
     // data passed to the callback lambda
-    auto from         = entity.name;
-    auto to           = sensor.target;
-    auto sensorName   = sensor.name;
+    auto from         = Symbol(entity);
+    auto to           = Symbol(sensor.target);
+    auto sensorName   = Symbol(sensor.name);
     auto sigma        = sensor.sigma;
     auto sensorTransf = sensor.transf;
 
@@ -135,6 +181,10 @@ void SensorListener::setupNonMarkerBasedSensor(const Entity& entity, const Senso
         // This marker does not exist.
         // Its sole purpose is to map the sensor
         // readings to an entity.
+        // the target has left, until it joins again
+        if (m_removedEntities.count(to))
+            return;
+
         atlas::MarkerData dataAdapter;
         dataAdapter.pos   = data->pose.position;
         dataAdapter.rot   = data->pose.orientation;
@@ -144,30 +194,37 @@ void SensorListener::setupNonMarkerBasedSensor(const Entity& entity, const Senso
     };
 
     // tell ros we want to listen to that topic
-    m_subscribers.push_back(m_node.subscribe<SensorCallback>(sensor.topic, 1000, callbackSensor));
     ROS_INFO("Suscribed to topic \"%s\"", sensor.topic.c_str());
+    return m_node.subscribe<SensorCallback>(sensor.topic, 1000, callbackSensor);
 }
 
 SensorDataList SensorListener::filteredSensorData() const
 {
     SensorDataList filteredSensorData;
+    this->filteredSensorData(filteredSensorData);
+
+    return filteredSensorData;
+}
+
+void SensorListener::filteredSensorData(SensorDataList& out) const
+{
+    out.resize(m_rawSensorData.size());
 
     // calculate a weighted average over the sensor data
+    auto outItr = out.begin();
+
     for (const auto& keyval : m_rawSensorData)
     {
         const auto& filter = keyval.second;
 
-        Measurement filteredData;
-        filteredData.key   = keyval.first;
-        filteredData.stamp = ros::Time::now();
+        // stamped with the arrival of the latest message, the graph derives the rate of the sensor from it
+        Measurement& filteredData = *outItr++;
+        filteredData.key          = keyval.first;
+        filteredData.stamp        = filter.timeOfLastValue();
         filteredData.transform.setOrigin(filter.vec3());
         filteredData.transform.setRotation(filter.quat());
         filteredData.sigma = filter.scalar();
-
-        filteredSensorData.push_back(filteredData);
     }
-
-    return filteredSensorData;
 }
 
 void SensorListener::clear()
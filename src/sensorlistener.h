@@ -20,10 +20,14 @@
 
 #include "config.h"
 #include "filters.h"
+#include "symbols.h"
 #include <atlas/MarkerData.h>
+#include <boost/functional/hash.hpp>
 #include <ros/ros.h>
 #include <tf2/LinearMath/Transform.h>
 
+#include <set>
+
 /**
  * @brief The SensorData struct
  */
@@ -31,7 +35,7 @@ struct Measurement
 {
     struct Key
     {
-        Key(const std::string& from, const std::string& to, const std::string& sensor, int marker)
+        Key(Symbol from, Symbol to, Symbol sensor, int marker)
             : from(from)
             , to(to)
             , sensor(sensor)
@@ -41,9 +45,9 @@ struct Measurement
 
         Key() {}
 
-        std::string from;
-        std::string to;
-        std::string sensor;
+        Symbol from;
+        Symbol to;
+        Symbol sensor;
         int marker = -1;
 
         // operators needed by std::map
@@ -56,6 +60,20 @@ struct Measurement
         {
             return std::tie(from, to, sensor, marker) == std::tie(other.from, other.to, other.sensor, other.marker);
         }
+
+        // hash needed by std::unordered_map
+        struct Hash
+        {
+            std::size_t operator()(const Key& key) const
+            {
+                std::size_t seed = 0;
+                boost::hash_combine(seed, key.from.id());
+                boost::hash_combine(seed, key.to.id());
+                boost::hash_combine(seed, key.sensor.id());
+                boost::hash_combine(seed, key.marker);
+                return seed;
+            }
+        };
     };
 
     /**
@@ -139,11 +157,30 @@ public:
      */
     SensorDataList filteredSensorData() const;
 
+    /**
+     * @brief filteredSensorData fills a given list, reusing its storage
+     * @param out: Receives a weighted average of all sensor measurements
+     */
+    void filteredSensorData(SensorDataList& out) const;
+
     /**
      * @brief clear clears all recorded sensor data
      */
     void clear();
 
+    /**
+     * @brief addEntity subscribes to the sensors of an entity and maps its markers.
+     * The previous subscriptions of an entity with the same name are replaced.
+     * @param entity
+     */
+    void addEntity(const Entity& entity);
+
+    /**
+     * @brief removeEntity unsubscribes from the sensors of an entity and forgets its markers
+     * @param name
+     */
+    void removeEntity(const std::string& name);
+
     /**
      * @brief onSensorDataAvailable is the callback used by ROS in case new data is available
      * @param from: Where the data origins from
@@ -151,19 +188,37 @@ public:
      * @param sensorTransform: The transformation from the sensor to the baselink of "from"
      * @param markerMsg: The marker message
      */
-    void onSensorDataAvailable(const std::string& from, const std::string& to, const std::string& sensor, const tf2::Transform& sensorTransform, const tf2::Transform& entityMarkerTransform, const atlas::MarkerData& markerMsg);
+    void onSensorDataAvailable(Symbol from, Symbol to, Symbol sensor, const tf2::Transform& sensorTransform, const tf2::Transform& entityMarkerTransform, const atlas::MarkerData& markerMsg);
 
 protected:
-    void setupMarkerBasedSensor(const Entity& entity, const Sensor& sensor);
-    void setupNonMarkerBasedSensor(const Entity& entity, const Sensor& sensor);
+    ros::Subscriber setupMarkerBasedSensor(const std::string& entity, const Sensor& sensor);
+    ros::Subscriber setupNonMarkerBasedSensor(const std::string& entity, const Sensor& sensor);
+
+    /**
+     * @brief The EntitySubscriptions struct
+     * The topics and markers registered by an entity
+     */
+    struct EntitySubscriptions
+    {
+        std::vector<ros::Subscriber> subscribers;
+        std::vector<int> markers;
+    };
 
 private:
     ros::NodeHandle m_node;
-    std::vector<ros::Subscriber> m_subscribers;
+
+    // the subscriptions by entity name
+    std::map<std::string, EntitySubscriptions> m_entities;
+
+    // the entities removed at runtime, the sensors targeting them are ignored
+    std::set<Symbol> m_removedEntities;
 
     // used to map from the marker id to the target entity
-    std::map<int, std::pair<std::string, Marker> > m_markers;
+    std::map<int, std::pair<Symbol, Marker> > m_markers;
 
     // sensor data
     SensorDataMap m_rawSensorData;
+
+    // the filters are reset after the given time without data
+    ros::Duration m_filterTimeout = ros::Duration(0.25);
 };
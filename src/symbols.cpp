@@ -0,0 +1,111 @@
+/*
+ * ATLAS - Cooperative sensing
+ * Copyright (C) 2017  Paul KREMER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "symbols.h"
+
+/**
+ * @brief Symbol
+ */
+
+Symbol::Symbol(const std::string& name)
+    : m_id(SymbolTable::instance().intern(name))
+{
+}
+
+Symbol::Symbol(const char* name)
+    : m_id(SymbolTable::instance().intern(name))
+{
+}
+
+const std::string& Symbol::str() const
+{
+    static const std::string empty;
+
+    if (m_id == -1)
+        return empty;
+
+    return SymbolTable::instance().name(m_id);
+}
+
+std::ostream& operator<<(std::ostream& os, const Symbol& symbol)
+{
+    return os << symbol.str();
+}
+
+/**
+ * @brief SymbolTable
+ */
+
+SymbolTable::SymbolTable()
+{
+}
+
+SymbolTable& SymbolTable::instance()
+{
+    static SymbolTable table;
+    return table;
+}
+
+int SymbolTable::intern(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto itr = m_ids.find(name);
+    if (itr != m_ids.end())
+        return itr->second;
+
+    const int id = int(m_names.size());
+    m_names.push_back(name);
+    m_ids[name] = id;
+
+    return id;
+}
+
+int SymbolTable::find(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto itr = m_ids.find(name);
+    return itr != m_ids.end() ? itr->second : -1;
+}
+
+const std::string& SymbolTable::name(int id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_names[id];
+}
+
+std::size_t SymbolTable::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_names.size();
+}
+
+void SymbolTable::populate(const Config& config)
+{
+    for (const auto& entity : config.entities())
+    {
+        intern(entity.name);
+
+        for (const auto& sensor : entity.sensors)
+        {
+            intern(sensor.name);
+            intern(sensor.target);
+        }
+    }
+}
@@ -0,0 +1,123 @@
+/*
+ * ATLAS - Cooperative sensing
+ * Copyright (C) 2017  Paul KREMER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "config.h"
+
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief The Symbol class
+ * A compact handle to an interned string (e.g. the name of an entity or sensor).
+ * Copying, comparing and hashing a symbol is as cheap as doing so with an integer.
+ */
+class Symbol
+{
+public:
+    Symbol() {}
+
+    /**
+     * @brief Symbol interns the given string
+     * @param name
+     */
+    Symbol(const std::string& name);
+    Symbol(const char* name);
+
+    /**
+     * @brief id
+     * @return The unique id of the symbol, -1 if the symbol is empty
+     */
+    int id() const { return m_id; }
+
+    /**
+     * @brief str
+     * @return The string the symbol stands for
+     */
+    const std::string& str() const;
+    const char* c_str() const { return str().c_str(); }
+
+    bool operator==(const Symbol& other) const { return m_id == other.m_id; }
+    bool operator!=(const Symbol& other) const { return m_id != other.m_id; }
+    bool operator<(const Symbol& other) const { return m_id < other.m_id; }
+
+private:
+    int m_id = -1;
+};
+
+std::ostream& operator<<(std::ostream& os, const Symbol& symbol);
+
+/**
+ * @brief The SymbolTable class
+ * Process wide table of the interned strings.
+ * Strings are resolved only at the boundaries (ROS, dot files),
+ * everything in between works on symbols.
+ */
+class SymbolTable
+{
+public:
+    /**
+     * @brief instance
+     * @return The process wide symbol table
+     */
+    static SymbolTable& instance();
+
+    /**
+     * @brief intern
+     * @param name
+     * @return The id of the given string, a new id is assigned on first use
+     */
+    int intern(const std::string& name);
+
+    /**
+     * @brief find
+     * @param name
+     * @return The id of the given string, -1 if it has not been interned
+     */
+    int find(const std::string& name) const;
+
+    /**
+     * @brief name
+     * @param id
+     * @return The string of the given id
+     */
+    const std::string& name(int id) const;
+
+    /**
+     * @brief size
+     * @return The number of interned strings
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief populate interns the names of all entities and sensors of a config
+     * @param config
+     */
+    void populate(const Config& config);
+
+private:
+    SymbolTable();
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, int> m_ids;
+    std::deque<std::string> m_names; ///< deque, references stay valid while growing
+};
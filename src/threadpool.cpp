@@ -0,0 +1,153 @@
+/*
+ * ATLAS - Cooperative sensing
+ * Copyright (C) 2017  Paul KREMER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "threadpool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(std::size_t threads)
+    : m_ranges(std::max<std::size_t>(threads, 1))
+{
+    // the calling thread is one of the threads
+    for (std::size_t i = 1; i < m_ranges.size(); ++i)
+        m_workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_wakeCondition.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+std::size_t ThreadPool::size() const
+{
+    return m_ranges.size();
+}
+
+void ThreadPool::parallelFor(std::size_t count, const Task& task)
+{
+    if (count == 0)
+        return;
+
+    // not worth waking up the workers
+    if (m_workers.empty() || count == 1)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            task(i);
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // split the loop into contiguous shares
+        for (std::size_t i = 0; i < m_ranges.size(); ++i)
+        {
+            std::lock_guard<std::mutex> rangeLock(m_ranges[i].mutex);
+            m_ranges[i].begin = count * i / m_ranges.size();
+            m_ranges[i].end   = count * (i + 1) / m_ranges.size();
+        }
+
+        m_task        = &task;
+        m_busyWorkers = m_workers.size();
+        m_generation++;
+    }
+
+    m_wakeCondition.notify_all();
+
+    runTasks(0);
+
+    // barrier, wait for the workers to finish the loop
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::work(std::size_t thread)
+{
+    std::size_t generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeCondition.wait(lock, [this, generation] { return m_stop || m_generation != generation; });
+
+            if (m_stop)
+                return;
+
+            generation = m_generation;
+        }
+
+        runTasks(thread);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busyWorkers == 0)
+                m_doneCondition.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runTasks(std::size_t thread)
+{
+    std::size_t index;
+
+    // work on our own share first
+    while (takeFront(m_ranges[thread], index))
+        (*m_task)(index);
+
+    // then help the others
+    for (std::size_t i = 1; i < m_ranges.size(); ++i)
+    {
+        auto& victim = m_ranges[(thread + i) % m_ranges.size()];
+
+        while (takeBack(victim, index))
+            (*m_task)(index);
+    }
+}
+
+bool ThreadPool::takeFront(Range& range, std::size_t& index)
+{
+    std::lock_guard<std::mutex> lock(range.mutex);
+
+    if (range.begin == range.end)
+        return false;
+
+    index = range.begin++;
+    return true;
+}
+
+bool ThreadPool::takeBack(Range& range, std::size_t& index)
+{
+    std::lock_guard<std::mutex> lock(range.mutex);
+
+    if (range.begin == range.end)
+        return false;
+
+    index = --range.end;
+    return true;
+}
@@ -0,0 +1,95 @@
+/*
+ * ATLAS - Cooperative sensing
+ * Copyright (C) 2017  Paul KREMER
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The ThreadPool class
+ * A set of persistent worker threads executing parallel loops.
+ * Every thread starts on its own share of the loop and steals
+ * from the others once it runs out of work.
+ */
+class ThreadPool
+{
+public:
+    using Task = std::function<void(std::size_t)>;
+
+    /**
+     * @brief ThreadPool
+     * @param threads: The total number of threads working on a loop, including the calling thread
+     */
+    explicit ThreadPool(std::size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief size
+     * @return The total number of threads working on a loop, including the calling thread
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief parallelFor calls task(i) for every i in [0, count).
+     * The calling thread takes part in the work. Returns once all calls are done.
+     * @param count
+     * @param task
+     */
+    void parallelFor(std::size_t count, const Task& task);
+
+protected:
+    /**
+     * @brief The Range struct
+     * The share of the loop owned by a thread.
+     * The owner takes from the front, thieves take from the back.
+     */
+    struct Range
+    {
+        std::mutex mutex;
+        std::size_t begin = 0;
+        std::size_t end   = 0;
+    };
+
+    void work(std::size_t thread);
+    void runTasks(std::size_t thread);
+
+    bool takeFront(Range& range, std::size_t& index);
+    bool takeBack(Range& range, std::size_t& index);
+
+private:
+    std::vector<std::thread> m_workers;
+    std::vector<Range> m_ranges; ///< one per thread, the calling thread owns the first one
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCondition;
+    std::condition_variable m_doneCondition;
+
+    // the current loop
+    const Task* m_task = nullptr;
+
+    std::size_t m_busyWorkers = 0; ///< workers still working on the current loop
+    std::size_t m_generation  = 0; ///< incremented for every loop
+    bool m_stop               = false;
+};
@@ -18,8 +18,47 @@
 
 #include "transformgraph.h"
 
-#include <boost/graph/dijkstra_shortest_paths.hpp>
-#include <boost/graph/graphviz.hpp>
+#include <angles/angles.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+// removes a single occurrence of an edge from an adjacency list
+// the order of the list does not matter
+void unlink(std::vector<int>& edges, int edge)
+{
+    auto itr = std::find(edges.begin(), edges.end(), edge);
+
+    if (itr != edges.end())
+    {
+        *itr = edges.back();
+        edges.pop_back();
+    }
+}
+
+// scratch space of the path searches
+// Each thread has its own, such that queries can run concurrently without allocating
+struct SearchScratch
+{
+    std::vector<double> cost;
+    std::vector<int> via;
+    std::vector<std::pair<double, int>> queue;
+    std::vector<int> path;
+};
+
+SearchScratch& searchScratch()
+{
+    static thread_local SearchScratch scratch;
+    return scratch;
+}
+}
 
 TransformGraph::TransformGraph(double decayDuration)
     : m_decayDuration(decayDuration)
@@ -27,45 +66,284 @@ TransformGraph::TransformGraph(double decayDuration)
     // world is a special entity
     addEntity("world");
 
-    // world is by definition always evaluated
-    auto vertexInfo = boost::get(vertexInfo_t(), m_graph);
+    // world is by definition always evaluated and never moves
+    const auto world = m_labeledVertex["world"];
+    setFlag(world, Evaluated);
+    setFlag(world, Static);
+    setFlag(world, Frozen);
 
-    vertexInfo[m_labeledVertex["world"]].evaluated = true;
+    // there is always a snapshot to read
+    publishSnapshot(ros::Time::now());
 }
 
 TransformGraph::TransformGraph(const Config& config)
     : TransformGraph(config.options().decayDuration)
 {
     for (const auto& entity : config.entities())
+    {
+        // rigidly attached entities are added once their carriers exist
+        if (config.resolveRigid(entity.name).carrier != entity.name)
+            continue;
+
         addEntity(entity.name);
+
+        if (entity.isStatic)
+            setStatic(entity.name);
+    }
+
+    for (const auto& entity : config.entities())
+    {
+        const auto attachment = config.resolveRigid(entity.name);
+
+        if (attachment.carrier != entity.name)
+            attachEntity(entity.name, attachment.carrier, attachment.transform);
+    }
+
+    setEvalThreads(config.options().evalThreads);
+    setEvalMode(config.options().evalMode, config.options().solverIterations);
+    setRefineBudget(config.options().refineBudget);
+    setHistorySize(std::size_t(std::max(0, config.options().historySize)));
+    setEdgeLifetime(config.options().edgeLifetimeFactor, config.options().maxEdgeLifetime, config.options().edgeHysteresis);
+    setStaticTolerance(config.options().staticTolerance, angles::from_degrees(config.options().staticAngleTolerance));
+}
+
+void TransformGraph::setEvalThreads(int threads)
+{
+    WriteLock lock(m_mutex);
+
+    if (threads > 1)
+        m_pool.reset(new ThreadPool(threads));
+    else
+        m_pool.reset();
+}
+
+void TransformGraph::setEvalMode(Options::EvalMode mode, int iterations)
+{
+    WriteLock lock(m_mutex);
+
+    m_evalMode         = mode;
+    m_solverIterations = iterations;
+}
+
+void TransformGraph::setRefineBudget(double budget)
+{
+    WriteLock lock(m_mutex);
+
+    m_refineBudget = budget;
+}
+
+void TransformGraph::setHistorySize(std::size_t size)
+{
+    WriteLock lock(m_mutex);
+
+    m_historySize = size;
+
+    for (auto& vertex : m_vertices)
+    {
+        if (vertex.carrier == -1)
+            vertex.history = PoseHistory(size);
+    }
+}
+
+void TransformGraph::setEdgeLifetime(double factor, double maxLifetime, double hysteresis)
+{
+    WriteLock lock(m_mutex);
+
+    m_lifetimeFactor     = factor;
+    m_maxLifetime        = maxLifetime;
+    m_lifetimeHysteresis = hysteresis;
+}
+
+void TransformGraph::setStatic(const std::string& entity, bool isStatic)
+{
+    WriteLock lock(m_mutex);
+
+    auto itr = m_labeledVertex.find(entity);
+
+    // the world is always static
+    if (itr == m_labeledVertex.end() || itr->second == m_labeledVertex["world"])
+        return;
+
+    auto& vertex = m_vertices[itr->second];
+
+    setFlag(itr->second, Static, isStatic);
+    vertex.settleCount = 0;
+    vertex.settleFilter.reset();
+
+    if (isStatic)
+        return;
+
+    // no longer an anchor
+    if (hasFlag(itr->second, Frozen))
+    {
+        setFlag(itr->second, Frozen, false);
+        m_topologyVersion++;
+    }
+
+    // the edges to other static entities decay again
+    // Each measurement has one edge in the incoming pairs, the heap holds its forward edge.
+    for (auto pair : vertex.inPairs)
+    {
+        for (auto edge : m_pairs[pair].edges)
+            scheduleExpiry(m_keyedEdges[m_edges[edge].sensorData.key].first);
+    }
+}
+
+void TransformGraph::setStaticTolerance(double distance, double angle)
+{
+    WriteLock lock(m_mutex);
+
+    m_staticTolerance      = distance;
+    m_staticAngleTolerance = angle;
+}
+
+bool TransformGraph::isFrozen(const std::string& entity) const
+{
+    ReadLock lock(m_mutex);
+
+    auto itr = m_labeledVertex.find(entity);
+    return itr != m_labeledVertex.end() && hasFlag(itr->second, Frozen);
 }
 
 void TransformGraph::addEntity(const std::string& name)
 {
-    if (hasEntity(name))
+    WriteLock lock(m_mutex);
+
+    if (!m_labeledVertex.count(name))
+        insertVertex(name);
+}
+
+void TransformGraph::attachEntity(const std::string& name, const std::string& carrier, const tf2::Transform& transform)
+{
+    WriteLock lock(m_mutex);
+
+    if (m_labeledVertex.count(name))
+        return;
+
+    auto itr = m_labeledVertex.find(carrier);
+
+    if (itr == m_labeledVertex.end())
+    {
+        ROS_WARN("Graph: Cannot attach '%s' to the missing entity '%s'", name.c_str(), carrier.c_str());
+        insertVertex(name);
         return;
+    }
+
+    // attached to an attached entity, use the carrier of the carrier
+    const auto& info   = m_vertices[itr->second];
+    const auto parent  = carrierOf(itr->second);
+    const auto attach  = info.attachTransform * transform;
+    const auto current = insertVertex(name);
 
+    m_vertices[current].carrier         = parent;
+    m_vertices[current].attachTransform = attach;
+    m_vertices[current].history         = PoseHistory();
+}
+
+TransformGraph::Vertex TransformGraph::insertVertex(const std::string& name)
+{
     // adding entities is like adding vertices to the graph
-    auto vertex           = boost::add_vertex(m_graph);
+    // the slots of removed entities are reused first
+    Vertex vertex;
+
+    if (!m_freeVertices.empty())
+    {
+        vertex = m_freeVertices.back();
+        m_freeVertices.pop_back();
+    }
+    else
+    {
+        vertex = Vertex(m_vertices.size());
+
+        m_vertices.emplace_back();
+        m_componentParent.push_back(vertex);
+        m_componentRank.push_back(0);
+
+        m_positions.emplace_back();
+        m_rotations.emplace_back();
+        m_levels.emplace_back();
+        m_fuseCounts.emplace_back();
+        m_updatePasses.emplace_back();
+        m_flags.emplace_back();
+    }
+
     m_labeledVertex[name] = vertex;
 
-    // set the index of the new vertex
-    auto indices    = boost::get(boost::vertex_index, m_graph);
-    indices[vertex] = m_count++;
+    // the hot path looks up the vertices by symbol
+    const auto symbol = Symbol(name);
+    if (symbol.id() >= int(m_symbolVertex.size()))
+        m_symbolVertex.resize(symbol.id() + 1, -1);
+
+    m_symbolVertex[symbol.id()] = vertex;
+    m_topologyVersion++;
+
+    // the new vertex is its own component
+    m_componentParent[vertex] = vertex;
+    m_componentRank[vertex]   = 0;
 
-    // set the name of the new vertex
-    auto vertexInfo         = boost::get(vertexInfo_t(), m_graph);
-    vertexInfo[vertex].name = name;
+    m_vertices[vertex].name    = name;
+    m_vertices[vertex].history = PoseHistory(m_historySize);
+
+    m_positions[vertex]    = Position::Zero();
+    m_rotations[vertex]    = Rotation::Identity();
+    m_levels[vertex]       = 0;
+    m_fuseCounts[vertex]   = 0;
+    m_updatePasses[vertex] = 0;
+    m_flags[vertex]        = Stale;
+
+    return vertex;
+}
+
+void TransformGraph::releaseVertex(Vertex vertex)
+{
+    auto& info = m_vertices[vertex];
+
+    m_labeledVertex.erase(info.name);
+    m_symbolVertex[Symbol(info.name).id()] = -1;
+
+    // frees the adjacency lists and the history, the slot is marked free by its empty name
+    info            = VertexInfo();
+    m_flags[vertex] = 0;
+
+    m_freeVertices.push_back(vertex);
+    m_topologyVersion++;
+}
+
+void TransformGraph::removeEntity(const std::string& name)
+{
+    WriteLock lock(m_mutex);
+
+    auto itr = m_labeledVertex.find(name);
+
+    // the world stays
+    if (itr == m_labeledVertex.end() || itr->second == m_labeledVertex["world"])
+        return;
+
+    // the entities rigidly attached to it leave along with it
+    const auto removed = rigidBody(itr->second);
+    removeEdgesOf(removed);
+
+    for (auto v : removed)
+        releaseVertex(v);
+
+    fuseDirtyPairs();
+
+    m_componentsOutdated = true;
+    rebuildComponents();
 }
 
 bool TransformGraph::hasEntity(const std::string& name) const
 {
+    ReadLock lock(m_mutex);
+
     auto itr = m_labeledVertex.find(name);
     return itr != m_labeledVertex.end();
 }
 
 std::vector<std::string> TransformGraph::entities() const
 {
+    ReadLock lock(m_mutex);
+
     std::vector<std::string> out;
 
     for (const auto& keyval : m_labeledVertex)
@@ -74,317 +352,1557 @@ std::vector<std::string> TransformGraph::entities() const
     return out;
 }
 
+TransformGraph::EntityHandle TransformGraph::entityHandle(const std::string& name) const
+{
+    ReadLock lock(m_mutex);
+
+    auto itr = m_labeledVertex.find(name);
+    return itr != m_labeledVertex.end() ? itr->second : -1;
+}
+
+std::string TransformGraph::entityName(EntityHandle entity) const
+{
+    ReadLock lock(m_mutex);
+
+    if (entity < 0 || entity >= EntityHandle(m_vertices.size()))
+        return std::string();
+
+    return m_vertices[entity].name;
+}
+
 int TransformGraph::fuseCount(const std::string& name) const
 {
+    ReadLock lock(m_mutex);
+
     auto itr = m_labeledVertex.find(name);
 
     if (itr != m_labeledVertex.end())
-    {
-        auto vInfo = boost::get(vertexInfo_t(), m_graph);
-        return vInfo[itr->second].fuseCount;
-    }
+        return m_fuseCounts[carrierOf(itr->second)];
 
     return -1;
 }
 
 void TransformGraph::updateSensorData(const Measurement& measurement)
 {
+    updateSensorData(&measurement, 1);
+}
 
-    // remove edges if they exist
-    removeEdgesByKey(measurement.key);
+void TransformGraph::updateSensorData(const Measurement* measurements, std::size_t count)
+{
+    WriteLock lock(m_mutex);
 
-    // edges do not exist, add them
-    auto info = EdgeInfo(measurement);
+    std::vector<Symbol> missing;
 
-    if (hasEntity(measurement.key.from) && hasEntity(measurement.key.to))
+    for (std::size_t i = 0; i < count; ++i)
     {
-        boost::add_edge(m_labeledVertex[measurement.key.from], m_labeledVertex[measurement.key.to], { 1.0, info }, m_graph);
-        boost::add_edge(m_labeledVertex[measurement.key.to], m_labeledVertex[measurement.key.from], { 1.0, info.inverse() }, m_graph);
+        const auto& key = measurements[i].key;
+
+        if (applyMeasurement(measurements[i]))
+            continue;
+
+        // collect the missing entities, they are reported once
+        for (const auto& symbol : { key.from, key.to })
+        {
+            if (vertex(symbol) == -1 && std::find(missing.begin(), missing.end(), symbol) == missing.end())
+                missing.push_back(symbol);
+        }
     }
-    else
+
+    if (!missing.empty())
     {
-        // missing entity
-        ROS_WARN("Graph: Missing entity '%s' or '%s'", measurement.key.from.c_str(), measurement.key.to.c_str());
+        std::string names;
+        for (const auto& symbol : missing)
+            names += (names.empty() ? "'" : ", '") + symbol.str() + "'";
+
+        // reported at most every few seconds rather than at the loop rate
+        ROS_WARN_THROTTLE(5.0, "Graph: Missing entities %s", names.c_str());
     }
+
+    fuseDirtyPairs();
 }
 
-void TransformGraph::update(const SensorListener& listener)
+void TransformGraph::updateSensorData(const SensorDataList& measurements)
 {
-    auto measurements = listener.filteredSensorData();
+    updateSensorData(measurements.data(), measurements.size());
+}
 
-    for (const auto& measurement : measurements)
-        updateSensorData(measurement);
+void TransformGraph::update(const SensorListener& listener)
+{
+    listener.filteredSensorData(m_measurements);
+    updateSensorData(m_measurements);
 
-    removeEdgesOlderThan(m_decayDuration);
+    removeExpiredEdges();
 
-    clearEvalFlag();
     eval();
 }
 
 void TransformGraph::removeAllEdges(const std::string& entity)
 {
-    boost::clear_vertex(m_labeledVertex[entity], m_graph);
+    WriteLock lock(m_mutex);
+
+    auto itr = m_labeledVertex.find(entity);
+
+    if (itr == m_labeledVertex.end())
+        return;
+
+    // an attached entity has no pairs of its own, its data is part of the pairs of its carrier
+    removeEdgesOf(rigidBody(itr->second));
+
+    fuseDirtyPairs();
+    rebuildComponents();
 }
 
 void TransformGraph::removeEdgesByKey(const Measurement::Key& key)
 {
-    RemovePredicateKey pred(key, m_graph);
-    boost::remove_edge_if(pred, m_graph);
-}
+    WriteLock lock(m_mutex);
 
-void TransformGraph::removeEdgesOlderThan(ros::Duration duration)
-{
-    RemovePredicateDuration pred(duration, ros::Time::now(), m_graph);
-    boost::remove_edge_if(pred, m_graph);
+    if (m_keyedEdges.count(key))
+        removeEdgePair(key);
+
+    fuseDirtyPairs();
+    rebuildComponents();
 }
 
-Pose TransformGraph::lookupPose(const std::string& entityName) const
+void TransformGraph::removeExpiredEdges()
 {
-    const auto vertexInfo = boost::get(vertexInfo_t(), m_graph);
+    WriteLock lock(m_mutex);
 
-    auto itr = m_labeledVertex.find(entityName);
-    if (itr != m_labeledVertex.end() && vertexInfo[itr->second].evaluated)
+    const auto now = ros::Time::now();
+
+    // only the expired edges and outdated heap entries are visited
+    while (!m_expiryHeap.empty() && m_expiryHeap.front().deadline <= now)
     {
-        return vertexInfo[itr->second].pose;
+        const auto expiry = m_expiryHeap.front();
+        std::pop_heap(m_expiryHeap.begin(), m_expiryHeap.end(), std::greater<Expiry>());
+        m_expiryHeap.pop_back();
+
+        // the edge might have been removed or updated in the meantime
+        // Its slot might even hold another measurement by now, e.g. the inverse edge of a newer one.
+        auto itr = m_keyedEdges.find(expiry.key);
+        if (itr == m_keyedEdges.end() || itr->second.first != expiry.edge)
+            continue;
+
+        const auto& info = m_edges[expiry.edge];
+        if (info.sensorData.stamp + info.lifetime > now)
+            continue;
+
+        // fixed infrastructure observing fixed infrastructure does not decay
+        if (hasFlag(info.source, Static) && hasFlag(info.target, Static))
+            continue;
+
+        removeEdgePair(info.sensorData.key);
     }
 
-    throw("\"" + entityName + "\" is not connected to \"world\"");
+    fuseDirtyPairs();
+    rebuildComponents();
 }
 
-std::vector<std::string> TransformGraph::lookupPath(const std::string& from, const std::string& to)
+void TransformGraph::removeEdgesOlderThan(ros::Duration duration)
 {
+    WriteLock lock(m_mutex);
 
-    auto d    = boost::get(boost::vertex_distance, m_graph); // distances
-    auto p    = boost::get(boost::vertex_predecessor, m_graph); // predecessors
-    auto info = boost::get(vertexInfo_t(), m_graph); // vertex info
+    const auto deadline = ros::Time::now() - duration;
 
-    auto start = m_labeledVertex[from];
-    auto goal  = m_labeledVertex[to];
+    // the heap is ordered by the lifetime of the edges, not by their age
+    std::vector<Measurement::Key> expired;
 
-    boost::dijkstra_shortest_paths(m_graph, start, boost::predecessor_map(p).distance_map(d));
+    for (const auto& keyval : m_keyedEdges)
+    {
+        const auto& info = m_edges[keyval.second.first];
 
-    // print graph
-    //    VertexIterator vi, vend;
-    //    for (boost::tie(vi, vend) = boost::vertices(m_graph); vi != vend; ++vi)
-    //    {
-    //        std::cout << "distance(" << *vi << ") = " << d[(*vi)] << ", ";
-    //        std::cout << "parent(" << *vi << ") = " << p[*vi] << std::endl;
-    //    }
+        // fixed infrastructure observing fixed infrastructure does not decay
+        if (info.sensorData.stamp <= deadline && !(hasFlag(info.source, Static) && hasFlag(info.target, Static)))
+            expired.push_back(keyval.first);
+    }
 
-    // travel from goal to start
-    std::vector<Edge> path;
-    std::vector<std::string> verticesInPath;
-    Vertex v = goal; // We want to start at the destination and work our way back to the source
-    for (Vertex u = p[v]; // Start by setting 'u' to the destintaion node's predecessor
-         u != v; // Keep tracking the path until we get to the source
-         v = u, u = p[v]) // Set the current vertex to the current predecessor, and the predecessor to one level up
-    {
-        std::pair<Graph::edge_descriptor, bool> edgePair = boost::edge(u, v, m_graph);
+    for (const auto& key : expired)
+        removeEdgePair(key);
 
-        if (!edgePair.second)
-            continue;
+    fuseDirtyPairs();
+    rebuildComponents();
+}
 
-        Graph::edge_descriptor edge = edgePair.first;
+Pose TransformGraph::lookupPose(const std::string& entityName) const
+{
+    ReadLock lock(m_mutex);
 
-        path.push_back(edge);
-    }
+    Pose pose;
 
-    //    std::cout << "Shortest path from " << from << " to " << to << ":" << std::endl;
-    for (auto itr = path.rbegin(); itr != path.rend(); ++itr)
+    auto itr = m_labeledVertex.find(entityName);
+    if (itr != m_labeledVertex.end() && entityPose(itr->second, pose))
     {
-        auto sourceVertex = boost::source(*itr, m_graph);
-        auto targetVertex = boost::target(*itr, m_graph);
+        return pose;
+    }
 
-        if (sourceVertex == Graph::null_vertex() || targetVertex == Graph::null_vertex())
-            continue;
+    throw("\"" + entityName + "\" is not connected to \"world\"");
+}
 
-        const auto& sourceName = info[sourceVertex].name;
-        const auto& targetName = info[targetVertex].name;
-        //        std::cout << sourceName << " -> " << targetName << " = " << boost::get(boost::edge_weight, m_graph, *itr) << std::endl;
+bool TransformGraph::lookupPose(EntityHandle entity, Pose& pose) const
+{
+    ReadLock lock(m_mutex);
 
-        if (itr == path.rbegin())
-            verticesInPath.push_back(sourceName);
+    if (entity < 0 || entity >= EntityHandle(m_vertices.size()))
+        return false;
 
-        verticesInPath.push_back(targetName);
-    }
-    //    std::cout << std::endl;
-    //    std::cout << "Distance: " << d[goal] << std::endl;
+    return entityPose(entity, pose);
+}
 
-    return verticesInPath;
+void TransformGraph::exportPoses(PoseTable& table) const
+{
+    ReadLock lock(m_mutex);
+    fillPoseTable(table);
 }
 
-tf2::Transform TransformGraph::lookupTransform(const std::string& from, const std::string& to)
+bool TransformGraph::lookupPose(EntityHandle entity, const ros::Time& time, Pose& pose) const
 {
-    auto path = lookupPath(from, to);
+    ReadLock lock(m_mutex);
 
-    if (path.empty())
-        return tf2::Transform(); //failed to lookup transform
+    if (entity < 0 || entity >= EntityHandle(m_vertices.size()))
+        return false;
 
-    return tf2::Transform();
+    return historicPose(entity, time, pose);
 }
 
-bool TransformGraph::canTransform(const std::string& from, const std::string& to)
+void TransformGraph::exportPoses(const ros::Time& time, PoseTable& table) const
 {
-    return !lookupPath(from, to).empty();
+    ReadLock lock(m_mutex);
+
+    table.resize(m_vertices.size());
+
+    for (std::size_t v = 0; v < m_vertices.size(); ++v)
+    {
+        auto& entry = table[v];
+
+        entry.evaluated = historicPose(Vertex(v), time, entry.pose);
+        entry.fuseCount = 0;
+        entry.level     = -1;
+    }
 }
 
-std::size_t TransformGraph::numberOfEdges() const
+std::shared_ptr<const TransformGraph::PoseSnapshot> TransformGraph::snapshot() const
 {
-    return boost::num_edges(m_graph);
+    return std::atomic_load(&m_snapshot);
 }
 
-void TransformGraph::eval()
+void TransformGraph::fillPoseTable(PoseTable& table) const
 {
-    class VertexVisitor : public boost::default_bfs_visitor
+    table.resize(m_vertices.size());
+
+    for (std::size_t v = 0; v < m_vertices.size(); ++v)
     {
-    public:
-        VertexVisitor(std::vector<Vertex>& vertices, std::map<Vertex, int>& levels)
-            : vertices(vertices)
-            , levels(levels)
-        {
-        }
+        // rigidly attached entities share the state of their carrier
+        const auto carrier = carrierOf(Vertex(v));
+        auto& entry        = table[v];
 
-        void discover_vertex(Vertex u, const Graph& graph)
-        {
-            // don't add the world, as its pose is already known
-            const auto& info = boost::get(vertexInfo_t(), graph); // vertex names
-            if (info[u].name != "world")
-                vertices.push_back(u);
-        }
+        entry.evaluated = entityPose(Vertex(v), entry.pose);
+        entry.fuseCount = m_fuseCounts[carrier];
+        entry.level     = entry.evaluated ? m_levels[carrier] : -1;
+    }
+}
 
-        void tree_edge(Edge e, const Graph&)
-        {
-            auto source = e.m_source;
-            auto target = e.m_target;
+std::vector<std::string> TransformGraph::lookupPath(const std::string& from, const std::string& to) const
+{
+    ReadLock lock(m_mutex);
 
-            levels[target] = levels[source] + 1;
-        }
+    std::vector<std::string> verticesInPath;
 
-    private:
-        std::vector<Vertex>& vertices;
-        std::map<Vertex, int>& levels;
-    };
+    auto fromItr = m_labeledVertex.find(from);
+    auto toItr   = m_labeledVertex.find(to);
 
-    std::vector<Vertex> vertices;
-    std::map<Vertex, int> levels;
-    auto vertexVisitor = VertexVisitor(vertices, levels);
+    if (fromItr == m_labeledVertex.end() || toItr == m_labeledVertex.end())
+        return verticesInPath;
 
-    // evaluate vertices on the "same level" first
-    boost::breadth_first_search(m_graph, m_labeledVertex["world"], boost::visitor(vertexVisitor));
+    // there is no chain of sensor data from an entity to itself
+    if (fromItr->second == toItr->second)
+        return verticesInPath;
 
-    auto vInfo = boost::get(vertexInfo_t(), m_graph); // vertex info
-    auto eInfo = boost::get(edgeInfo_t(), m_graph); // edge info
+    // the path leads along the carriers of rigidly attached entities
+    const auto start = carrierOf(fromItr->second);
+    const auto goal  = carrierOf(toItr->second);
 
-    // move the levels information to the vertex properties
-    // for easy access
-    for (const auto& currentVertex : vertices)
+    // both on the same rigid body, the path is just their carrier
+    if (goal == start)
     {
-        vInfo[currentVertex].level = levels[currentVertex];
+        verticesInPath.push_back(m_vertices[start].name);
+        return verticesInPath;
     }
 
-    // evaluate the vertices on the stack
-    for (const auto& currentVertex : vertices)
-    {
-        auto itrs = boost::in_edges(currentVertex, m_graph);
+    auto& pairs = searchScratch().path;
 
-        // find smallest sigma (i.e. the "best" sensor)
-        // used to calculate the weight
-        auto minItr = std::min_element(itrs.first, itrs.second, [&eInfo](Edge a, Edge b) {
-            return eInfo[a].sensorData.sigma < eInfo[b].sensorData.sigma;
-        });
-        const double minSigma = eInfo[*minItr].sensorData.sigma;
+    // the goal is not reachable
+    if (!shortestPath(start, goal, pairs))
+        return verticesInPath;
 
-        vInfo[currentVertex].fuseCount = 0;
+    verticesInPath.push_back(m_vertices[start].name);
 
-        // evaluate edges
-        for (auto edge : boost::make_iterator_range(itrs.first, itrs.second))
-        {
-            // get the source vertex of that edge
-            const auto sourceVertex = edge.m_source;
+    for (auto pair : pairs)
+        verticesInPath.push_back(m_vertices[m_pairs[pair].target].name);
 
-            // if the source hasn't been evaluated yet, we just skip it
-            // as it is of no value to us
-            // The same applies to vertices that have the same distance to the world
-            if (!vInfo[sourceVertex].evaluated || vInfo[sourceVertex].level >= vInfo[currentVertex].level)
-                continue;
+    return verticesInPath;
+}
+
+tf2::Transform TransformGraph::lookupTransform(const std::string& from, const std::string& to) const
+{
+    ReadLock lock(m_mutex);
 
-            // the source has been evaluated and as such we can use it
-            // for the pose calculation
-            // The edges contain the transformation
-            // The vertices contain the pose
-            const auto vertextransform = tf2::Transform{ vInfo[sourceVertex].pose.rot, vInfo[sourceVertex].pose.pos };
-            const auto edgetransform   = eInfo[edge].sensorData.transform;
+    auto fromItr = m_labeledVertex.find(from);
+    auto toItr   = m_labeledVertex.find(to);
 
-            const auto result = vertextransform * edgetransform;
+    if (fromItr == m_labeledVertex.end() || toItr == m_labeledVertex.end() || fromItr->second == toItr->second)
+        return tf2::Transform::getIdentity();
+
+    tf2::Transform transform;
+
+    if (!carrierTransform(carrierOf(fromItr->second), carrierOf(toItr->second), transform))
+        return tf2::Transform::getIdentity(); //there is no path
+
+    // expand the rigidly attached entities
+    return m_vertices[fromItr->second].attachTransform.inverse() * transform * m_vertices[toItr->second].attachTransform;
+}
 
-            // the standard deviation
-            const auto sigma = eInfo[edge].sensorData.sigma;
+bool TransformGraph::carrierTransform(Vertex from, Vertex to, tf2::Transform& transform) const
+{
+    if (from == to)
+    {
+        transform = tf2::Transform::getIdentity();
+        return true;
+    }
 
-            // the weight. Lower sigmas are weighted higher.
-            const auto weight = minSigma / sigma;
+    const auto key = (std::uint64_t(from) << 32) | std::uint32_t(to);
 
-            // inc fuse count
-            vInfo[currentVertex].fuseCount++;
+    {
+        std::lock_guard<std::mutex> cacheLock(m_pathCacheMutex);
 
-            // filter
-            vInfo[currentVertex].filter.addVec3(result.getOrigin(), weight);
-            vInfo[currentVertex].filter.addQuat(result.getRotation(), weight);
+        // paths of an outdated topology might use pairs that no longer exist
+        if (m_pathCacheVersion != m_topologyVersion)
+        {
+            m_pathCache.clear();
+            m_pathCacheVersion = m_topologyVersion;
         }
 
-        // get the results from the filter
-        vInfo[currentVertex].pose.pos = vInfo[currentVertex].filter.weightedMeanVec3();
-        vInfo[currentVertex].pose.rot = vInfo[currentVertex].filter.weightedMeanQuat();
+        auto itr = m_pathCache.find(key);
+
+        // the path is still the best one, but the transforms might have changed
+        if (itr != m_pathCache.end() && itr->second.weightVersion == m_pairWeightVersion)
+        {
+            auto& cached = itr->second;
+
+            if (cached.valueVersion != m_pairValueVersion)
+            {
+                cached.transform    = composePath(cached.pairs);
+                cached.valueVersion = m_pairValueVersion;
+            }
 
-        vInfo[currentVertex].evaluated = true;
-        vInfo[currentVertex].filter.reset();
+            transform = cached.transform;
+            return !cached.pairs.empty();
+        }
     }
+
+    // There is no path yet or the accuracies have changed and another path might be better now.
+    // The search does not block the other queries.
+    CachedPath path;
+
+    if (!shortestPath(from, to, path.pairs))
+        path.pairs.clear();
+
+    path.transform     = composePath(path.pairs);
+    path.weightVersion = m_pairWeightVersion;
+    path.valueVersion  = m_pairValueVersion;
+
+    std::lock_guard<std::mutex> cacheLock(m_pathCacheMutex);
+    m_pathCache[key] = path;
+
+    transform = path.transform;
+    return !path.pairs.empty();
 }
 
-void TransformGraph::save(const std::string& filename)
+bool TransformGraph::canTransform(const std::string& from, const std::string& to) const
 {
-    std::ofstream file;
-    file.open(filename, std::ofstream::out | std::ofstream::trunc);
-    file << toDot();
+    ReadLock lock(m_mutex);
+
+    auto fromItr = m_labeledVertex.find(from);
+    auto toItr   = m_labeledVertex.find(to);
+
+    // there is no chain of sensor data from an entity to itself
+    if (fromItr == m_labeledVertex.end() || toItr == m_labeledVertex.end() || fromItr->second == toItr->second)
+        return false;
+
+    return component(carrierOf(fromItr->second)) == component(carrierOf(toItr->second));
 }
 
-std::string TransformGraph::toDot() const
+std::vector<std::string> TransformGraph::connectedEntities(const std::string& entity) const
 {
-    std::stringstream ss;
+    ReadLock lock(m_mutex);
+
+    std::vector<std::string> out;
 
-    auto vertexInfo = boost::get(vertexInfo_t(), m_graph);
-    auto edgeInfo   = boost::get(edgeInfo_t(), m_graph);
+    auto itr = m_labeledVertex.find(entity);
+    if (itr == m_labeledVertex.end())
+        return out;
 
-    boost::write_graphviz(ss, m_graph, boost::make_label_writer(vertexInfo), boost::make_label_writer(edgeInfo));
+    const auto root = component(carrierOf(itr->second));
 
-    return ss.str();
+    for (Vertex v = 0; v < Vertex(m_vertices.size()); ++v)
+    {
+        if (v != itr->second && component(carrierOf(v)) == root)
+            out.push_back(m_vertices[v].name);
+    }
+
+    return out;
 }
 
-void TransformGraph::clearEvalFlag()
+std::size_t TransformGraph::numberOfEdges() const
 {
-    auto vInfo = boost::get(vertexInfo_t(), m_graph);
+    ReadLock lock(m_mutex);
 
-    for (const auto& keyval : m_labeledVertex)
-        if (keyval.first != "world")
-            vInfo[keyval.second].evaluated = false;
+    return m_edges.size() - m_freeEdges.size();
 }
 
-////////////////////////////////////////////////////
-// print helpers
-////////////////////////////////////////////////////
-
-// The following information is displayed on edges
-std::ostream& operator<<(std::ostream& os, const TransformGraph::EdgeInfo& info)
+void TransformGraph::eval()
+{
+    WriteLock lock(m_mutex);
+
+    // the anchors are part of the ordering
+    checkAnchors();
+
+    // the ordering only changes along with the topology
+    updateTraversal();
+    m_evalPass++;
+
+    // The islands are independent of each other, evaluate them as separate tasks.
+    // This does not pay off if most of the vertices are part of the same island.
+    const auto islands = m_islandBegin.size() - 1;
+
+    if (m_pool && islands > 1 && 2 * m_largestIsland <= m_islandVertices.size())
+    {
+        m_pool->parallelFor(islands, [this](std::size_t island) {
+            for (auto i = m_islandBegin[island]; i < m_islandBegin[island + 1]; ++i)
+                evalVertex(m_islandVertices[i]);
+        });
+    }
+    else
+    {
+        // evaluate the vertices level by level
+        // don't evaluate the world (level 0), as its pose is already known
+        // the vertices of a level only depend on the lower levels and can be evaluated in parallel
+        for (std::size_t level = 1; level + 1 < m_levelBegin.size(); ++level)
+        {
+            const auto begin = m_levelBegin[level];
+            const auto count = m_levelBegin[level + 1] - begin;
+
+            if (m_pool && count >= m_minParallelCount)
+            {
+                m_pool->parallelFor(count, [this, begin](std::size_t i) { evalVertex(m_traversal[begin + i]); });
+            }
+            else
+            {
+                for (std::size_t i = begin; i < begin + count; ++i)
+                    evalVertex(m_traversal[i]);
+            }
+        }
+    }
+
+    // the greedy poses serve as the initial guess of the new vertices
+    if (m_evalMode == Options::EvalMode::Optimize)
+        optimize();
+    else if (m_refineBudget > 0.0)
+        refine();
+
+    // static entities have been frozen, they become anchors in the next evaluation
+    if (m_anchorsChanged.exchange(false))
+        m_topologyVersion++;
+
+    const auto stamp = ros::Time::now();
+    recordHistory(stamp);
+    publishSnapshot(stamp);
+}
+
+void TransformGraph::evalVertex(Vertex vertex)
+{
+    // the solver refines the known poses, only the new vertices are initialized here
+    if (m_evalMode == Options::EvalMode::Optimize && hasFlag(vertex, Evaluated))
+        return;
+
+    const auto& inPairs = m_vertices[vertex].inPairs;
+    const auto level    = m_levels[vertex];
+
+    // re-evaluate if one of the pairs or one of the sources changed
+    // The sources are on the lower levels, which are done at this point
+    bool stale = hasFlag(vertex, Stale);
+
+    for (auto pair : inPairs)
+    {
+        const auto source = m_pairs[pair].source;
+        stale             = stale || (m_levels[source] < level && m_updatePasses[source] == m_evalPass);
+    }
+
+    // keep the pose
+    if (!stale)
+        return;
+
+    // find smallest sigma (i.e. the "best" sensor)
+    // used to calculate the weight
+    auto minItr = std::min_element(inPairs.begin(), inPairs.end(), [this](Pair a, Pair b) {
+        return m_pairs[a].sigma < m_pairs[b].sigma;
+    });
+    const double minSigma = m_pairs[*minItr].sigma;
+
+    // filter used to fuse the sensor data, fixed size and thus cheap to create
+    WeightedMean filter;
+    int fuseCount = 0;
+
+    // evaluate the pairs, each of them carries the fused transform
+    // of all the edges between the source and the current vertex
+    for (auto pair : inPairs)
+    {
+        // get the source vertex of that pair
+        const auto source = m_pairs[pair].source;
+
+        // vertices that have the same distance to the world are skipped
+        // The same applies to sources that haven't been evaluated yet
+        // as they are of no value to us
+        if (m_levels[source] >= level || !hasFlag(source, Evaluated))
+            continue;
+
+        // the source has been evaluated and as such we can use it
+        // for the pose calculation
+        // The edges contain the transformation
+        // The vertices contain the pose
+        const auto vertextransform = PoseT<FusionScalar>(m_positions[source], m_rotations[source]);
+        const auto& edgetransform  = m_pairs[pair].transform;
+
+        const auto result = vertextransform * edgetransform;
+
+        // the standard deviation
+        const auto sigma = m_pairs[pair].sigma;
+
+        // the weight. Lower sigmas are weighted higher.
+        const auto weight = minSigma / sigma;
+
+        // inc fuse count
+        fuseCount += int(m_pairs[pair].edges.size());
+
+        // filter
+        filter.addPose(result, FusionScalar(weight));
+    }
+
+    // the first evaluation starts settling a static entity
+    const auto previous = hasFlag(vertex, Evaluated) ? pose(vertex) : Pose();
+
+    // get the results from the filter
+    const auto mean = filter.weightedMeanPose();
+
+    m_positions[vertex]    = mean.pos;
+    m_rotations[vertex]    = mean.rot;
+    m_fuseCounts[vertex]   = fuseCount;
+    m_updatePasses[vertex] = m_evalPass;
+
+    setFlag(vertex, Evaluated);
+    setFlag(vertex, Stale, false);
+
+    // the solver settles the static entities in the optimize mode
+    if (hasFlag(vertex, Static) && m_evalMode == Options::EvalMode::Greedy)
+        settle(vertex, previous);
+}
+
+void TransformGraph::optimize()
+{
+    // the anchors are on the first level, they are fixed
+    const auto anchors = m_levelBegin[1];
+
+    m_solver.clear();
+    m_solverIndex.assign(m_vertices.size(), -1);
+
+    for (std::size_t i = 0; i < m_traversal.size(); ++i)
+    {
+        const auto v = m_traversal[i];
+
+        m_solverIndex[v] = m_solver.addPose(pose(v), i < anchors);
+
+        if (i >= anchors)
+            m_fuseCounts[v] = 0;
+    }
+
+    // every pair has its inverse, each of them is added once
+    for (const auto& info : m_pairs)
+    {
+        if (info.source == -1 || info.source > info.target)
+            continue;
+
+        const auto source = m_solverIndex[info.source];
+        const auto target = m_solverIndex[info.target];
+
+        if (source == -1 || target == -1)
+            continue;
+
+        PoseGraphSolver::Constraint constraint;
+        constraint.source    = source;
+        constraint.target    = target;
+        constraint.transform = info.transform.toTransform();
+        constraint.sigma     = info.sigma;
+
+        m_solver.addConstraint(constraint);
+
+        // all the measurements of a vertex are fused
+        if (m_levels[info.source] != 0)
+            m_fuseCounts[info.source] += int(info.edges.size());
+
+        if (m_levels[info.target] != 0)
+            m_fuseCounts[info.target] += int(info.edges.size());
+    }
+
+    if (m_solver.solve(m_solverIterations) < 0)
+    {
+        ROS_WARN("Graph: Cannot solve the pose graph");
+        return;
+    }
+
+    for (std::size_t i = anchors; i < m_traversal.size(); ++i)
+    {
+        const auto v        = m_traversal[i];
+        const auto previous = pose(v);
+        const auto& solved  = m_solver.pose(m_solverIndex[v]);
+
+        m_positions[v]    = fromTf2<FusionScalar>(solved.pos);
+        m_rotations[v]    = fromTf2<FusionScalar>(solved.rot);
+        m_updatePasses[v] = m_evalPass;
+        setFlag(v, Stale, false);
+
+        if (hasFlag(v, Static))
+            settle(v, previous);
+    }
+}
+
+void TransformGraph::refine()
+{
+    using Clock = std::chrono::steady_clock;
+
+    const auto budget   = std::chrono::duration<double>(m_refineBudget);
+    const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(budget);
+
+    // the anchors are on the first level, they keep their pose
+    const auto anchors  = m_levelBegin[1];
+    std::size_t visited = 0;
+
+    for (;;)
+    {
+        double maxChange = 0.0;
+
+        // the updated poses are used right away by the following vertices
+        for (std::size_t i = anchors; i < m_traversal.size(); ++i)
+        {
+            // the budget is checked within the sweep, an interrupted sweep still improves the poses
+            if (++visited % m_refineClockSkip == 0 && Clock::now() >= deadline)
+                return;
+
+            const auto v        = m_traversal[i];
+            const auto& inPairs = m_vertices[v].inPairs;
+
+            auto minItr = std::min_element(inPairs.begin(), inPairs.end(), [this](Pair a, Pair b) {
+                return m_pairs[a].sigma < m_pairs[b].sigma;
+            });
+            const double minSigma = m_pairs[*minItr].sigma;
+
+            // fuse all the neighbours regardless of their level
+            WeightedMean filter;
+
+            for (auto pair : inPairs)
+            {
+                const auto source = m_pairs[pair].source;
+
+                if (!hasFlag(source, Evaluated))
+                    continue;
+
+                const auto result = PoseT<FusionScalar>(m_positions[source], m_rotations[source]) * m_pairs[pair].transform;
+                const auto weight = minSigma / m_pairs[pair].sigma;
+
+                filter.addPose(result, FusionScalar(weight));
+            }
+
+            const auto mean   = filter.weightedMeanPose();
+            const auto change = double(std::max((mean.pos - m_positions[v]).norm(), mean.rot.angularDistance(m_rotations[v])));
+
+            m_positions[v] = mean.pos;
+            m_rotations[v] = mean.rot;
+
+            if (change > m_refineTolerance)
+                m_updatePasses[v] = m_evalPass;
+
+            maxChange = std::max(maxChange, change);
+        }
+
+        if (maxChange < m_refineTolerance || Clock::now() >= deadline)
+            return;
+    }
+}
+
+void TransformGraph::save(const std::string& filename)
+{
+    std::ofstream file;
+    file.open(filename, std::ofstream::out | std::ofstream::trunc);
+    file << toDot();
+}
+
+std::string TransformGraph::toDot() const
+{
+    ReadLock lock(m_mutex);
+
+    std::stringstream ss;
+
+    ss << "digraph G {\n";
+
+    for (std::size_t v = 0; v < m_vertices.size(); ++v)
+    {
+        // free slot
+        if (m_vertices[v].name.empty())
+            continue;
+
+        // The following information is displayed on vertices
+        const auto& pos = m_positions[v];
+        const auto& rot = m_rotations[v];
+
+        ss << v << "[label=\""
+           << "Name: " << m_vertices[v].name << '\n'
+           << "pos: " << pos.x() << "/" << pos.y() << "/" << pos.z() << '\n'
+           << "quat: " << rot.x() << "/" << rot.y() << "/" << rot.z() << "/" << rot.w() << '\n'
+           << "lvl: " << m_levels[v] << "\"];\n";
+
+        // rigid attachments
+        if (m_vertices[v].carrier != -1)
+            ss << m_vertices[v].carrier << "->" << v << " [style=dashed];\n";
+    }
+
+    for (const auto& edge : m_edges)
+    {
+        if (edge.source != -1)
+            ss << edge.source << "->" << edge.target << " [label=\"" << edge << "\"];\n";
+    }
+
+    ss << "}\n";
+
+    return ss.str();
+}
+
+void TransformGraph::clearEvalFlag()
+{
+    WriteLock lock(m_mutex);
+
+    // the static entities have to settle again
+    const auto world = m_labeledVertex["world"];
+
+    for (Vertex v = 0; v < Vertex(m_vertices.size()); ++v)
+    {
+        if (v != world && hasFlag(v, Frozen))
+        {
+            setFlag(v, Frozen, false);
+            m_topologyVersion++;
+        }
+    }
+
+    invalidatePoses();
+}
+
+void TransformGraph::publishSnapshot(const ros::Time& stamp)
+{
+    // A buffer is free once the graph holds its only reference, i.e. it is neither published
+    // nor held by a reader. The readers can only obtain the published one.
+    std::size_t index = m_snapshotBuffers.size();
+
+    for (std::size_t i = 1; i <= m_snapshotBuffers.size(); ++i)
+    {
+        const auto candidate = (m_publishedBuffer + i) % m_snapshotBuffers.size();
+        auto& buffer         = m_snapshotBuffers[candidate];
+
+        if (!buffer)
+            buffer = std::make_shared<PoseSnapshot>();
+        else if (buffer.use_count() != 1)
+            continue;
+
+        // orders the last reads of the released readers before the refill
+        // (they release their references with release semantics, ThreadSanitizer does not model the fence)
+        std::atomic_thread_fence(std::memory_order_acquire);
+        index = candidate;
+        break;
+    }
+
+    // the readers hold on to all of them, leave the next one to its readers
+    if (index == m_snapshotBuffers.size())
+    {
+        index                    = (m_publishedBuffer + 1) % m_snapshotBuffers.size();
+        m_snapshotBuffers[index] = std::make_shared<PoseSnapshot>();
+    }
+
+    auto& snapshot = *m_snapshotBuffers[index];
+
+    snapshot.version = m_evalPass;
+    snapshot.stamp   = stamp;
+    fillPoseTable(snapshot.poses);
+
+    m_publishedBuffer = index;
+    std::atomic_store(&m_snapshot, std::shared_ptr<const PoseSnapshot>(m_snapshotBuffers[index]));
+}
+
+void TransformGraph::invalidatePoses()
+{
+    // the world and the frozen entities keep their pose
+    for (auto& flags : m_flags)
+    {
+        if (!(flags & Frozen))
+            flags = (flags & ~Evaluated) | Stale;
+    }
+}
+
+void TransformGraph::checkAnchors()
+{
+    // the anchors are on the first level of the previous traversal
+    const auto anchors = m_levelBegin.size() > 1 ? m_levelBegin[1] : 0;
+    const auto world   = m_labeledVertex["world"];
+
+    for (std::size_t i = 0; i < anchors; ++i)
+    {
+        const auto anchor = m_traversal[i];
+
+        // only changed measurements can re-arm an anchor
+        if (anchor == world || !hasFlag(anchor, Frozen) || !hasFlag(anchor, Stale))
+            continue;
+
+        setFlag(anchor, Stale, false);
+
+        // compare against the best sensor looking at the anchor
+        Pair best = -1;
+
+        for (auto pair : m_vertices[anchor].inPairs)
+        {
+            if (hasFlag(m_pairs[pair].source, Evaluated) && (best == -1 || m_pairs[pair].sigma < m_pairs[best].sigma))
+                best = pair;
+        }
+
+        if (best == -1)
+            continue;
+
+        const auto source   = m_pairs[best].source;
+        const auto measured = PoseT<FusionScalar>(m_positions[source], m_rotations[source]) * m_pairs[best].transform;
+
+        // the entity has been moved, evaluate it again
+        if (deviates(pose(anchor), measured.toPose()))
+        {
+            setFlag(anchor, Frozen, false);
+            setFlag(anchor, Stale);
+            m_topologyVersion++;
+        }
+    }
+}
+
+void TransformGraph::settle(Vertex vertex, const Pose& previous)
+{
+    auto& info = m_vertices[vertex];
+
+    // start over if the pose moved
+    if (deviates(pose(vertex), previous))
+    {
+        info.settleCount = 0;
+        info.settleFilter.reset();
+    }
+
+    info.settleFilter.addPose({ m_positions[vertex], m_rotations[vertex] }, 1);
+
+    if (++info.settleCount < m_staticSettleCount)
+        return;
+
+    // the pose is frozen at the mean of the settled poses
+    const auto settled = info.settleFilter.weightedMeanPose();
+
+    m_positions[vertex] = settled.pos;
+    m_rotations[vertex] = settled.rot;
+    setFlag(vertex, Frozen);
+
+    info.settleCount = 0;
+    info.settleFilter.reset();
+
+    m_anchorsChanged = true;
+}
+
+bool TransformGraph::deviates(const Pose& a, const Pose& b) const
+{
+    return a.pos.distance(b.pos) > m_staticTolerance || a.rot.angleShortestPath(b.rot) > m_staticAngleTolerance;
+}
+
+bool TransformGraph::hasFlag(Vertex vertex, VertexFlag flag) const
+{
+    return (m_flags[vertex] & flag) != 0;
+}
+
+void TransformGraph::setFlag(Vertex vertex, VertexFlag flag, bool enabled)
+{
+    if (enabled)
+        m_flags[vertex] |= flag;
+    else
+        m_flags[vertex] &= ~flag;
+}
+
+Pose TransformGraph::pose(Vertex vertex) const
+{
+    return { toTf2(m_positions[vertex]), toTf2(m_rotations[vertex]) };
+}
+
+TransformGraph::Edge TransformGraph::addEdge(const EdgeInfo& info)
+{
+    Edge edge;
+
+    // reuse a free slot if possible
+    if (!m_freeEdges.empty())
+    {
+        edge = m_freeEdges.back();
+        m_freeEdges.pop_back();
+        m_edges[edge] = info;
+    }
+    else
+    {
+        edge = Edge(m_edges.size());
+        m_edges.push_back(info);
+    }
+
+    // find the pair connecting the two vertices
+    auto& outPairs = m_vertices[info.source].outPairs;
+    auto pairItr   = std::find_if(outPairs.begin(), outPairs.end(), [this, &info](Pair pair) {
+        return m_pairs[pair].target == info.target;
+    });
+
+    Pair pair;
+
+    if (pairItr != outPairs.end())
+    {
+        pair = *pairItr;
+    }
+    else
+    {
+        // first edge between these vertices, create the pair
+        if (!m_freePairs.empty())
+        {
+            pair = m_freePairs.back();
+            m_freePairs.pop_back();
+        }
+        else
+        {
+            pair = Pair(m_pairs.size());
+            m_pairs.emplace_back();
+        }
+
+        m_pairs[pair].source = info.source;
+        m_pairs[pair].target = info.target;
+
+        outPairs.push_back(pair);
+        m_vertices[info.target].inPairs.push_back(pair);
+        m_topologyVersion++;
+
+        uniteComponents(info.source, info.target);
+    }
+
+    m_edges[edge].pair = pair;
+    m_pairs[pair].edges.push_back(edge);
+    markDirty(pair);
+
+    return edge;
+}
+
+void TransformGraph::removeEdge(Edge edge)
+{
+    auto& info = m_edges[edge];
+    auto& pair = m_pairs[info.pair];
+
+    unlink(pair.edges, edge);
+    markDirty(info.pair);
+
+    // the last edge is gone, remove the pair
+    if (pair.edges.empty())
+    {
+        unlink(m_vertices[pair.source].outPairs, info.pair);
+        unlink(m_vertices[pair.target].inPairs, info.pair);
+
+        pair.source = -1;
+        pair.target = -1;
+        m_freePairs.push_back(info.pair);
+        m_topologyVersion++;
+
+        // the components might split up
+        m_componentsOutdated = true;
+    }
+
+    info.source = -1;
+    info.target = -1;
+    info.pair   = -1;
+    m_freeEdges.push_back(edge);
+}
+
+void TransformGraph::markDirty(Pair pair)
+{
+    if (!m_pairs[pair].dirty)
+    {
+        m_pairs[pair].dirty = true;
+        m_dirtyPairs.push_back(pair);
+    }
+}
+
+void TransformGraph::fuseDirtyPairs()
+{
+    // the cached paths have to be recomposed
+    if (!m_dirtyPairs.empty())
+        m_pairValueVersion++;
+
+    for (auto pair : m_dirtyPairs)
+    {
+        auto& info = m_pairs[pair];
+        info.dirty = false;
+
+        // the pair has been removed
+        if (info.source == -1)
+            continue;
+
+        // the target has to be re-evaluated
+        setFlag(info.target, Stale);
+
+        const double previousSigma = info.sigma;
+
+        // a single edge does not need any fusion
+        if (info.edges.size() == 1)
+        {
+            info.transform = PoseT<FusionScalar>(m_edges[info.edges.front()].sensorData.transform);
+            info.sigma     = m_edges[info.edges.front()].sensorData.sigma;
+        }
+        else
+        {
+            fusePair(info);
+        }
+
+        // the cached paths might no longer be the best ones
+        if (info.sigma != previousSigma)
+            m_pairWeightVersion++;
+    }
+
+    m_dirtyPairs.clear();
+}
+
+void TransformGraph::fusePair(PairInfo& info)
+{
+    // The edges are weighted by their inverse sigma.
+    // The combined sigma is chosen such that the pair weighs
+    // as much as its edges would weigh on their own.
+    double weights = 0.0;
+
+    for (auto edge : info.edges)
+    {
+        const auto& sensorData = m_edges[edge].sensorData;
+        const double weight    = 1.0 / std::max(sensorData.sigma, std::numeric_limits<double>::min());
+
+        m_pairFilter.addVec3(sensorData.transform.getOrigin(), weight);
+        m_pairFilter.addQuat(sensorData.transform.getRotation(), weight);
+        weights += weight;
+    }
+
+    info.transform = m_pairFilter.weightedMeanPose();
+    info.sigma     = 1.0 / weights;
+
+    m_pairFilter.reset();
+}
+
+void TransformGraph::removeEdgePair(Measurement::Key key)
+{
+    auto itr = m_keyedEdges.find(key);
+
+    removeEdge(itr->second.first);
+    removeEdge(itr->second.second);
+
+    m_keyedEdges.erase(itr);
+}
+
+std::vector<TransformGraph::Vertex> TransformGraph::rigidBody(Vertex vertex) const
+{
+    std::vector<Vertex> vertices = { vertex };
+
+    // the chains of attachments are resolved on insertion, they all point to the carrier
+    for (Vertex v = 0; v < Vertex(m_vertices.size()); ++v)
+    {
+        if (m_vertices[v].carrier == vertex)
+            vertices.push_back(v);
+    }
+
+    return vertices;
+}
+
+void TransformGraph::removeEdgesOf(const std::vector<Vertex>& vertices)
+{
+    // The measurements of attached entities are folded into the pairs of their carriers, the keys are kept.
+    std::vector<Measurement::Key> keys;
+
+    for (const auto& keyval : m_keyedEdges)
+    {
+        for (auto symbol : { keyval.first.from, keyval.first.to })
+        {
+            if (std::find(vertices.begin(), vertices.end(), vertex(symbol)) != vertices.end())
+            {
+                keys.push_back(keyval.first);
+                break;
+            }
+        }
+    }
+
+    // every edge has its inverse, hence the outgoing pairs are gone as well
+    for (const auto& key : keys)
+        removeEdgePair(key);
+}
+
+void TransformGraph::scheduleExpiry(Edge edge)
+{
+    // outdated entries pile up if the graph is never cleaned up,
+    // rebuild the heap from the live edges in that case
+    // (this includes the given edge, as it is already indexed)
+    if (m_expiryHeap.size() > 4 * m_keyedEdges.size() + 64)
+    {
+        m_expiryHeap.clear();
+
+        for (const auto& keyval : m_keyedEdges)
+        {
+            const auto& info = m_edges[keyval.second.first];
+            m_expiryHeap.push_back({ info.sensorData.stamp + info.lifetime, keyval.second.first, keyval.first });
+        }
+
+        std::make_heap(m_expiryHeap.begin(), m_expiryHeap.end(), std::greater<Expiry>());
+        return;
+    }
+
+    const auto& info = m_edges[edge];
+
+    m_expiryHeap.push_back({ info.sensorData.stamp + info.lifetime, edge, info.sensorData.key });
+    std::push_heap(m_expiryHeap.begin(), m_expiryHeap.end(), std::greater<Expiry>());
+}
+
+void TransformGraph::updateLifetime(EdgeInfo& info, const ros::Time& stamp)
+{
+    const double interval = (stamp - info.sensorData.stamp).toSec();
+
+    // out of order
+    if (interval <= 0.0)
+        return;
+
+    info.interval = info.arrivals == 0 ? interval : (1.0 - m_intervalAlpha) * info.interval + m_intervalAlpha * interval;
+    info.arrivals = std::min(info.arrivals + 1, m_establishedArrivals);
+
+    // a few messages may be late or lost before the edge expires
+    double lifetime = m_lifetimeFactor * info.interval;
+
+    if (info.arrivals == m_establishedArrivals)
+        lifetime *= m_lifetimeHysteresis;
+
+    info.lifetime = ros::Duration(std::min(std::max(lifetime, m_decayDuration.toSec()), m_maxLifetime));
+}
+
+std::size_t TransformGraph::topologyVersion() const
+{
+    ReadLock lock(m_mutex);
+
+    return m_topologyVersion;
+}
+
+void TransformGraph::updateTraversal()
+{
+    if (m_traversalVersion == m_topologyVersion)
+        return;
+
+    const auto world = m_labeledVertex["world"];
+
+    // the levels change, evaluate everything from scratch
+    // the vertices that are no longer reachable stay unevaluated
+    invalidatePoses();
+
+    // evaluate vertices on the "same level" first
+    // i.e. breadth first search starting at the world
+    // The frozen static entities are known as well and start on the same level as the world.
+    std::vector<bool> discovered(m_vertices.size(), false);
+    m_traversal.clear();
+
+    discovered[world] = true;
+    m_levels[world]   = 0;
+    m_traversal.push_back(world);
+    m_levelBegin.assign(1, 0);
+
+    for (Vertex v = 0; v < Vertex(m_vertices.size()); ++v)
+    {
+        if (v != world && hasFlag(v, Frozen))
+        {
+            discovered[v] = true;
+            m_levels[v]   = 0;
+            m_traversal.push_back(v);
+        }
+    }
+
+    for (std::size_t i = 0; i < m_traversal.size(); ++i)
+    {
+        const auto source = m_traversal[i];
+
+        for (auto pair : m_vertices[source].outPairs)
+        {
+            const auto target = m_pairs[pair].target;
+
+            if (!discovered[target])
+            {
+                discovered[target] = true;
+                m_levels[target]   = m_levels[source] + 1;
+
+                // the traversal is sorted by level, a new level starts here
+                if (m_levels[target] == int(m_levelBegin.size()))
+                    m_levelBegin.push_back(m_traversal.size());
+
+                m_traversal.push_back(target);
+            }
+        }
+    }
+
+    m_levelBegin.push_back(m_traversal.size());
+
+    // Split the reachable vertices into islands, i.e. the parts of the graph
+    // that are only connected to each other through the world (or the other anchors).
+    // As the poses of the anchors are fixed, the islands do not depend on each other.
+    const auto anchors = m_levelBegin[1];
+
+    std::vector<int> island(m_vertices.size(), -1);
+    std::vector<Vertex> stack;
+    int islands = 0;
+
+    for (std::size_t i = anchors; i < m_traversal.size(); ++i)
+    {
+        if (island[m_traversal[i]] != -1)
+            continue;
+
+        // flood fill, every pair has its inverse
+        island[m_traversal[i]] = islands;
+        stack.push_back(m_traversal[i]);
+
+        while (!stack.empty())
+        {
+            const auto source = stack.back();
+            stack.pop_back();
+
+            for (auto pair : m_vertices[source].outPairs)
+            {
+                const auto target = m_pairs[pair].target;
+
+                if (m_levels[target] != 0 && island[target] == -1)
+                {
+                    island[target] = islands;
+                    stack.push_back(target);
+                }
+            }
+        }
+
+        islands++;
+    }
+
+    // group the vertices by island, the level order is kept within each island
+    m_islandBegin.assign(islands + 1, 0);
+
+    for (std::size_t i = anchors; i < m_traversal.size(); ++i)
+        m_islandBegin[island[m_traversal[i]] + 1]++;
+
+    m_largestIsland = 0;
+    for (int i = 0; i < islands; ++i)
+    {
+        m_largestIsland = std::max(m_largestIsland, m_islandBegin[i + 1]);
+        m_islandBegin[i + 1] += m_islandBegin[i];
+    }
+
+    std::vector<std::size_t> next(m_islandBegin.begin(), m_islandBegin.end() - 1);
+    m_islandVertices.resize(m_traversal.size() - anchors);
+
+    for (std::size_t i = anchors; i < m_traversal.size(); ++i)
+        m_islandVertices[next[island[m_traversal[i]]]++] = m_traversal[i];
+
+    m_traversalVersion = m_topologyVersion;
+}
+
+bool TransformGraph::shortestPath(Vertex start, Vertex goal, std::vector<Pair>& pairs) const
+{
+    pairs.clear();
+
+    // there is no need to search disconnected components
+    if (component(start) != component(goal))
+        return false;
+
+    auto& scratch = searchScratch();
+    auto& queue   = scratch.queue;
+
+    scratch.cost.assign(m_vertices.size(), std::numeric_limits<double>::infinity());
+    scratch.via.assign(m_vertices.size(), -1);
+    queue.clear();
+
+    // The variances of chained transforms add up,
+    // hence the pairs are weighted by their variance
+    // The queue is a min-heap on the cost
+    using Candidate     = std::pair<double, Vertex>;
+    const auto ordering = std::greater<Candidate>();
+
+    scratch.cost[start] = 0.0;
+    queue.emplace_back(0.0, start);
+
+    while (!queue.empty())
+    {
+        std::pop_heap(queue.begin(), queue.end(), ordering);
+        const auto candidate = queue.back();
+        queue.pop_back();
+
+        if (candidate.second == goal)
+            break;
+
+        // outdated entry, the vertex has been reached cheaper
+        if (candidate.first > scratch.cost[candidate.second])
+            continue;
+
+        for (auto pair : m_vertices[candidate.second].outPairs)
+        {
+            const auto& info = m_pairs[pair];
+            const auto cost  = candidate.first + info.sigma * info.sigma;
+
+            if (cost < scratch.cost[info.target])
+            {
+                scratch.cost[info.target] = cost;
+                scratch.via[info.target]  = pair;
+                queue.emplace_back(cost, info.target);
+                std::push_heap(queue.begin(), queue.end(), ordering);
+            }
+        }
+    }
+
+    if (scratch.via[goal] == -1)
+        return false;
+
+    // travel from goal to start
+    for (Vertex v = goal; v != start; v = m_pairs[scratch.via[v]].source)
+        pairs.push_back(scratch.via[v]);
+
+    std::reverse(pairs.begin(), pairs.end());
+
+    return true;
+}
+
+tf2::Transform TransformGraph::composePath(const std::vector<Pair>& pairs) const
+{
+    PoseT<FusionScalar> transform;
+
+    for (auto pair : pairs)
+        transform = transform * m_pairs[pair].transform;
+
+    return transform.toTransform();
+}
+
+TransformGraph::Vertex TransformGraph::component(Vertex vertex) const
+{
+    // the trees are flattened by the rebuilds and only grow by rank in between, no need to compress them here
+    while (m_componentParent[vertex] != vertex)
+        vertex = m_componentParent[vertex];
+
+    return vertex;
+}
+
+void TransformGraph::rebuildComponents()
+{
+    if (!m_componentsOutdated)
+        return;
+
+    m_componentsOutdated = false;
+
+    // start over and merge along the remaining pairs
+    for (Vertex v = 0; v < Vertex(m_vertices.size()); ++v)
+    {
+        m_componentParent[v] = v;
+        m_componentRank[v]   = 0;
+    }
+
+    for (const auto& pair : m_pairs)
+    {
+        if (pair.source != -1)
+            uniteComponents(pair.source, pair.target);
+    }
+
+    // point every vertex directly to its root, the queries cannot compress the paths themselves
+    for (Vertex v = 0; v < Vertex(m_vertices.size()); ++v)
+        m_componentParent[v] = component(v);
+}
+
+void TransformGraph::uniteComponents(Vertex a, Vertex b)
+{
+    // the components are rebuilt anyway
+    if (m_componentsOutdated)
+        return;
+
+    // find the roots, halving the paths on the way
+    for (auto vertex : { &a, &b })
+    {
+        while (m_componentParent[*vertex] != *vertex)
+        {
+            m_componentParent[*vertex] = m_componentParent[m_componentParent[*vertex]];
+            *vertex                    = m_componentParent[*vertex];
+        }
+    }
+
+    if (a == b)
+        return;
+
+    // attach the smaller tree to the larger one
+    if (m_componentRank[a] < m_componentRank[b])
+        std::swap(a, b);
+
+    m_componentParent[b] = a;
+
+    if (m_componentRank[a] == m_componentRank[b])
+        m_componentRank[a]++;
+}
+
+TransformGraph::Vertex TransformGraph::carrierOf(Vertex vertex) const
+{
+    const auto carrier = m_vertices[vertex].carrier;
+    return carrier != -1 ? carrier : vertex;
+}
+
+bool TransformGraph::entityPose(Vertex vertex, Pose& pose) const
+{
+    const auto& info   = m_vertices[vertex];
+    const auto carrier = carrierOf(vertex);
+
+    if (!hasFlag(carrier, Evaluated))
+        return false;
+
+    pose = info.carrier == -1 ? this->pose(vertex) : attachedPose(vertex, this->pose(carrier));
+    return true;
+}
+
+bool TransformGraph::historicPose(Vertex vertex, const ros::Time& time, Pose& pose) const
+{
+    const auto& info = m_vertices[vertex];
+
+    // rigidly attached entities derive their pose from the history of their carrier
+    if (info.carrier == -1)
+        return info.history.lookup(time, pose);
+
+    Pose carrierPose;
+
+    if (!m_vertices[info.carrier].history.lookup(time, carrierPose))
+        return false;
+
+    pose = attachedPose(vertex, carrierPose);
+    return true;
+}
+
+Pose TransformGraph::attachedPose(Vertex vertex, const Pose& carrierPose) const
+{
+    // expand the rigidly attached entity
+    const auto transform = tf2::Transform{ carrierPose.rot, carrierPose.pos } * m_vertices[vertex].attachTransform;
+
+    return { transform.getOrigin(), transform.getRotation() };
+}
+
+void TransformGraph::recordHistory(const ros::Time& stamp)
+{
+    for (Vertex v = 0; v < Vertex(m_vertices.size()); ++v)
+    {
+        auto& history = m_vertices[v].history;
+
+        // lookups do not interpolate across the time an entity was not connected
+        if (hasFlag(v, Evaluated))
+            history.push(stamp, pose(v));
+        else
+            history.pushGap(stamp);
+    }
+}
+
+TransformGraph::Vertex TransformGraph::vertex(Symbol symbol) const
+{
+    if (symbol.id() < 0 || symbol.id() >= int(m_symbolVertex.size()))
+        return -1;
+
+    return m_symbolVertex[symbol.id()];
+}
+
+bool TransformGraph::applyMeasurement(const Measurement& measurement)
+{
+    const auto from = vertex(measurement.key.from);
+    const auto to   = vertex(measurement.key.to);
+
+    // missing entity
+    if (from == -1 || to == -1)
+        return false;
+
+    // both ends on the same rigid body (e.g. a payload camera seeing a marker on the gimbal)
+    // The measurement would be a loop on the carrier, it tells nothing about its pose.
+    if (carrierOf(from) == carrierOf(to))
+    {
+        ROS_DEBUG("Graph: Dropped a measurement within the rigid body '%s'", m_vertices[carrierOf(from)].name.c_str());
+        return true;
+    }
+
+    // measurements of rigidly attached entities are moved to their carriers
+    // Only the chains of attachments are composed at load time (Config::resolveRigid), the measurements
+    // are folded here as they arrive. Their keys name the attached entities, such that their data can be
+    // removed along with them.
+    if (m_vertices[from].carrier != -1 || m_vertices[to].carrier != -1)
+    {
+        auto folded      = measurement;
+        folded.transform = m_vertices[from].attachTransform * measurement.transform * m_vertices[to].attachTransform.inverse();
+
+        applyMeasurement(folded, carrierOf(from), carrierOf(to));
+        return true;
+    }
+
+    applyMeasurement(measurement, from, to);
+    return true;
+}
+
+void TransformGraph::applyMeasurement(const Measurement& measurement, Vertex from, Vertex to)
+{
+    // the edges exist, update them in place
+    auto itr = m_keyedEdges.find(measurement.key);
+    if (itr != m_keyedEdges.end())
+    {
+        auto& forward = m_edges[itr->second.first].sensorData;
+        auto& inverse = m_edges[itr->second.second].sensorData;
+
+        const bool restamped = forward.stamp != measurement.stamp;
+
+        if (restamped)
+            updateLifetime(m_edges[itr->second.first], measurement.stamp);
+
+        forward           = measurement;
+        inverse           = measurement;
+        inverse.transform = measurement.transform.inverse();
+
+        if (restamped)
+            scheduleExpiry(itr->second.first);
+
+        markDirty(m_edges[itr->second.first].pair);
+        markDirty(m_edges[itr->second.second].pair);
+        return;
+    }
+
+    // edges do not exist, add them
+    // the rate of the sensor is not known yet
+    auto info     = EdgeInfo(measurement);
+    info.source   = from;
+    info.target   = to;
+    info.lifetime = m_decayDuration;
+
+    const auto forward = addEdge(info);
+
+    m_keyedEdges[measurement.key] = { forward, addEdge(info.inverse()) };
+    scheduleExpiry(forward);
+}
+
+////////////////////////////////////////////////////
+// print helpers
+////////////////////////////////////////////////////
+
+// The following information is displayed on edges
+std::ostream& operator<<(std::ostream& os, const TransformGraph::EdgeInfo& info)
 {
     return os << "source: " << info.sensorData.key.from << '\n'
               << "sensor: " << info.sensorData.key.sensor << '\n'
               << "marker: " << info.sensorData.key.marker;
 }
 
-// The following information is displayed on vertices
-std::ostream& operator<<(std::ostream& os, const TransformGraph::VertexInfo& info)
-{
-    return os << "Name: " << info.name << '\n'
-              << "pos: " << info.pose.pos.x() << "/" << info.pose.pos.y() << "/" << info.pose.pos.z() << '\n'
-              << "quat: " << info.pose.rot.x() << "/" << info.pose.rot.y() << "/" << info.pose.rot.z() << "/" << info.pose.rot.w() << '\n'
-              << "lvl: " << info.level;
-}
@@ -18,18 +18,40 @@
 
 #pragma once
 
+#include "alignedallocator.h"
 #include "config.h"
 #include "filters.h"
 #include "helpers.h"
+#include "posegraphsolver.h"
+#include "posehistory.h"
 #include "sensorlistener.h"
+#include "symbols.h"
+#include "threadpool.h"
 
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/graph_traits.hpp>
+#include <boost/thread/shared_mutex.hpp>
 #include <ros/time.h>
 #include <tf2/LinearMath/Transform.h>
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 class TransformGraph
 {
+    // vertices, edges and pairs are addressed by their index in the flat storage
+    using Vertex = int;
+    using Edge   = int;
+    using Pair   = int;
+
+    // the pose table is stored in the precision of the fusion core
+    using Position = Eigen::Matrix<FusionScalar, 3, 1>;
+    using Rotation = Eigen::Quaternion<FusionScalar>;
+
     /**
    * @brief The EdgeInfo struct
    * Contains the information needed to travel from A to B
@@ -52,103 +74,125 @@ class TransformGraph
             auto copy = *this;
 
             copy.sensorData.transform = copy.sensorData.transform.inverse();
+            std::swap(copy.source, copy.target);
 
             return copy;
         }
 
         Measurement sensorData;
+
+        Vertex source = -1; ///< the vertex this edge is leaving, -1 if the slot is free
+        Vertex target = -1; ///< the vertex this edge is pointing to
+        Pair pair     = -1; ///< the pair this edge contributes to
+
+        // the rate of the sensor, only maintained on the forward edge of a measurement
+        ros::Duration lifetime; ///< the time without data after which the edge expires
+        double interval = 0.0; ///< the average time between two measurements in seconds
+        int arrivals    = 0; ///< the number of measurements received since the edge exists
+    };
+
+    /**
+     * @brief The PairInfo struct
+     * Aggregates all the edges going from one vertex to another
+     * into a single logical edge, which is what the evaluation works on
+     */
+    struct PairInfo
+    {
+        Vertex source = -1; ///< the vertex this pair is leaving, -1 if the slot is free
+        Vertex target = -1; ///< the vertex this pair is pointing to
+
+        PoseT<FusionScalar> transform; ///< the sigma-weighted fused transform of the edges
+        double sigma = 1.0; ///< the combined standard deviation of the edges
+
+        std::vector<Edge> edges; ///< the contributing edges
+        bool dirty = false; ///< the fused transform is outdated
     };
 
     /**
      * @brief The VertexInfo struct
-     * Contains all the data associated with a given vertex
+     * Contains the data associated with a given vertex that is rarely touched by the evaluation.
+     * The per-evaluation state lives in the pose table of the graph.
      */
     struct VertexInfo
     {
-        std::string name; ///< name of the vertex (entity
+        std::string name; ///< name of the vertex (entity), empty if the slot is free
 
-        Pose pose; ///< the pose in the world frame
+        int settleCount = 0; ///< the number of consecutive evaluations the pose stayed within the tolerance
+        WeightedMean settleFilter; ///< averages the poses while settling
 
-        WeightedMean filter; ///< filter used to fuse the sensor data
-        bool evaluated = false;
-        int level      = 0;
-        int fuseCount  = 0; ///< the number of fused sources
+        Vertex carrier = -1; ///< the vertex this one is rigidly attached to, -1 if it moves freely
+        tf2::Transform attachTransform = tf2::Transform::getIdentity(); ///< the transformation relative to the carrier
 
-        friend std::ostream& operator<<(std::ostream& os, const VertexInfo& info);
-    };
-
-    friend std::ostream& operator<<(std::ostream& os, const TransformGraph::EdgeInfo& info);
-    friend std::ostream& operator<<(std::ostream& os, const TransformGraph::VertexInfo& info);
+        std::vector<Pair> inPairs; ///< pairs pointing to this vertex
+        std::vector<Pair> outPairs; ///< pairs leaving this vertex
 
-    // boost graph property glue
-    struct edgeInfo_t
-    {
-        typedef boost::edge_property_tag kind;
+        PoseHistory history; ///< the poses of the previous evaluations, empty if rigidly attached
     };
 
-    struct vertexInfo_t
+    /**
+     * @brief The VertexFlag enum
+     * The boolean state of a vertex, packed into a single byte
+     */
+    enum VertexFlag : std::uint8_t
     {
-        typedef boost::vertex_property_tag kind;
+        Evaluated = 1 << 0, ///< the pose is valid
+        Stale     = 1 << 1, ///< the pose has to be re-evaluated
+        Static    = 1 << 2, ///< the entity does not move
+        Frozen    = 1 << 3, ///< the pose of the static entity has settled and is no longer evaluated
     };
 
-    // boost graph shortcuts
-    using vertex_descriptor = boost::adjacency_list_traits<boost::listS, boost::listS, boost::directedS>::vertex_descriptor;
-    using VertexProp        = boost::property<boost::vertex_index_t, int, boost::property<boost::vertex_distance_t, int, boost::property<boost::vertex_predecessor_t, vertex_descriptor, boost::property<vertexInfo_t, VertexInfo> > > >;
-    using EdgePropInfo      = boost::property<edgeInfo_t, EdgeInfo>;
-    using EdgeProp          = boost::property<boost::edge_weight_t, double, EdgePropInfo>;
-    using Graph             = boost::adjacency_list<boost::multisetS, boost::listS, boost::bidirectionalS, VertexProp, EdgeProp, boost::multisetS>;
-    using Vertex            = boost::graph_traits<Graph>::vertex_descriptor;
-    using Edge              = boost::graph_traits<Graph>::edge_descriptor;
-    using InEdgeIterator    = boost::graph_traits<Graph>::in_edge_iterator;
-    using VertexIterator    = boost::graph_traits<Graph>::vertex_iterator;
-
     /**
-     * @brief The RemovePredicateKey struct
-     * Used to remove specific edges from the graph by key
+     * @brief The Expiry struct
+     * Entry of the expiry heap. Entries are not removed when an edge is updated
+     * or removed, instead they are discarded once they reach the top of the heap
+     * and no longer match the deadline of their edge. The slots of removed edges are
+     * reused, the key tells whether the slot still holds the same measurement.
      */
-    struct RemovePredicateKey
+    struct Expiry
     {
-        RemovePredicateKey(const Measurement::Key& key, const Graph& graph)
-            : key(key)
-            , graph(graph)
-        {
-        }
-
-        const Measurement::Key& key;
-        const Graph& graph;
+        ros::Time deadline; ///< the time the edge expires at, as of the insertion
+        Edge edge; ///< the forward edge of the measurement
+        Measurement::Key key; ///< the measurement the edge belonged to, as of the insertion
 
-        bool operator()(const Edge& edge) const
+        // the earliest deadline has to be on top of the heap
+        bool operator>(const Expiry& other) const
         {
-            const auto& infoMap = boost::get(edgeInfo_t(), graph);
-            return infoMap[edge].sensorData.key == key;
+            return deadline > other.deadline;
         }
     };
 
+    friend std::ostream& operator<<(std::ostream& os, const TransformGraph::EdgeInfo& info);
+
+public:
+    // entities are addressed by a handle that is stable until the entity is removed, -1 if invalid
+    using EntityHandle = Vertex;
+
     /**
-     * @brief The RemovePredicateDuration struct
-     * Used to remove specific edges from the graph by duration
+     * @brief The PoseEntry struct
+     * The state of an entity as exported by exportPoses
      */
-    struct RemovePredicateDuration
+    struct PoseEntry
     {
-        RemovePredicateDuration(ros::Duration duration, ros::Time now, const Graph& graph)
-            : duration(duration)
-            , now(now)
-            , graph(graph)
-        {
-        }
+        Pose pose; ///< the pose in the world frame, only valid if evaluated
+        int fuseCount  = 0; ///< the number of fused sensor data
+        int level      = -1; ///< the distance to the world, -1 if not evaluated
+        bool evaluated = false; ///< the entity is connected to the world
+    };
 
-        ros::Duration duration;
-        ros::Time now;
-        const Graph& graph;
+    // the states of all the entities, indexed by their handle
+    using PoseTable = std::vector<PoseEntry>;
 
-        bool operator()(const Edge& edge) const
-        {
-            const auto& infoMap = boost::get(edgeInfo_t(), graph);
-            return (now - infoMap[edge].sensorData.stamp) >= duration;
-        }
+    /**
+     * @brief The PoseSnapshot struct
+     * The immutable result of an evaluation
+     */
+    struct PoseSnapshot
+    {
+        std::size_t version = 0; ///< the evaluation the poses originate from
+        ros::Time stamp; ///< the time of the evaluation
+        PoseTable poses; ///< the states of the entities at that time
     };
 
-public:
     /**
      * @brief TransformGraph creates an empty graph only containing a "world" entity
      */
@@ -159,12 +203,93 @@ public:
      */
     TransformGraph(const Config& config);
 
+    /**
+     * @brief setEvalThreads sets the number of threads used by eval()
+     * @param threads: 1 evaluates on the calling thread only
+     */
+    void setEvalThreads(int threads);
+
+    /**
+     * @brief setEvalMode selects the way eval() calculates the poses
+     * @param mode: Greedy fuses the poses level by level. Optimize additionally solves
+     * the whole graph as a least-squares problem, including the loops and the
+     * connections within a level, warm started from the poses of the previous evaluation.
+     * @param iterations: The iteration budget of the solver per evaluation
+     */
+    void setEvalMode(Options::EvalMode mode, int iterations = 2);
+
+    /**
+     * @brief setRefineBudget enables the refinement sweeps of the greedy evaluation.
+     * After the greedy pass, every vertex is re-fused from all of its evaluated neighbours,
+     * including the ones on the same level, until the poses converge or the time runs out.
+     * @param budget: The time in seconds spent per evaluation, 0 disables the refinement
+     */
+    void setRefineBudget(double budget);
+
+    /**
+     * @brief setHistorySize sets the number of evaluated poses kept per entity.
+     * The storage is allocated upfront, the existing histories are cleared.
+     * @param size
+     */
+    void setHistorySize(std::size_t size);
+
+    /**
+     * @brief setEdgeLifetime configures how long edges survive without data.
+     * The lifetime of an edge follows the message rate of its sensor, bounded by
+     * the decay duration and the given maximum.
+     * @param factor: The number of average message intervals without data after which an edge expires
+     * @param maxLifetime: The upper bound of the lifetime in seconds
+     * @param hysteresis: The lifetime multiplier of the edges whose sensor has been reporting steadily
+     */
+    void setEdgeLifetime(double factor, double maxLifetime, double hysteresis);
+
+    /**
+     * @brief setStatic marks an entity as fixed infrastructure.
+     * Its pose is frozen once it settled and its edges to other static entities do not decay.
+     * Frozen entities are only re-evaluated if a measurement deviates by more than the tolerance.
+     * @param entity
+     * @param isStatic
+     */
+    void setStatic(const std::string& entity, bool isStatic = true);
+
+    /**
+     * @brief setStaticTolerance sets the deviation at which frozen static entities are re-evaluated
+     * @param distance: in meters
+     * @param angle: in radians
+     */
+    void setStaticTolerance(double distance, double angle);
+
+    /**
+     * @brief isFrozen
+     * @param entity
+     * @return True if the pose of the static entity has settled and is no longer evaluated
+     */
+    bool isFrozen(const std::string& entity) const;
+
     /**
      * @brief addEntity creates a named vertex in the graph
      * @param name
      */
     void addEntity(const std::string& name);
 
+    /**
+     * @brief attachEntity creates an entity rigidly attached to another one.
+     * It is folded into the vertex of its carrier and never evaluated on its own,
+     * its pose is derived from the carrier on lookup.
+     * @param name
+     * @param carrier: The entity carrying the new one
+     * @param transform: The transformation relative to the carrier
+     */
+    void attachEntity(const std::string& name, const std::string& carrier, const tf2::Transform& transform);
+
+    /**
+     * @brief removeEntity removes an entity along with its sensor data and the entities attached to it.
+     * The sensor data of an attached entity is removed from its carrier.
+     * Its slot is reused by the next entity, hence its handle becomes invalid.
+     * @param name
+     */
+    void removeEntity(const std::string& name);
+
     /**
      * @brief hasEntity
      * @param name
@@ -178,6 +303,20 @@ public:
      */
     std::vector<std::string> entities() const;
 
+    /**
+     * @brief entityHandle
+     * @param name of the entity
+     * @return The handle of the entity, -1 if it does not exist
+     */
+    EntityHandle entityHandle(const std::string& name) const;
+
+    /**
+     * @brief entityName
+     * @param entity: The handle of the entity
+     * @return The name of the entity, empty if the handle is invalid
+     */
+    std::string entityName(EntityHandle entity) const;
+
     /**
      * @brief fuseCount
      * @param name of the entity
@@ -193,6 +332,20 @@ public:
      */
     void updateSensorData(const Measurement& measurement);
 
+    /**
+     * @brief updateSensorData applies a batch of measurements in a single pass.
+     * Missing entities are reported once per batch.
+     * @param measurements: Pointer to the first measurement of a contiguous range
+     * @param count: The number of measurements in the range
+     */
+    void updateSensorData(const Measurement* measurements, std::size_t count);
+
+    /**
+     * @brief updateSensorData applies a batch of measurements in a single pass
+     * @param measurements
+     */
+    void updateSensorData(const SensorDataList& measurements);
+
     /**
      * @brief update updates from a sensor listener and removes expired edges, also evaluates the graph
      * @param listener: Used to update the graph
@@ -200,7 +353,8 @@ public:
     void update(const SensorListener& listener);
 
     /**
-     * @brief removeAllEdges removes all sensor data assigned to a given entity
+     * @brief removeAllEdges removes all sensor data assigned to a given entity,
+     * including the data of the entities rigidly attached to it
      * @param entity
      */
     void removeAllEdges(const std::string& entity);
@@ -211,6 +365,11 @@ public:
      */
     void removeEdgesByKey(const Measurement::Key& key);
 
+    /**
+     * @brief removeExpiredEdges removes the edges that exceeded their lifetime
+     */
+    void removeExpiredEdges();
+
     /**
      * @brief removeEdgesOlderThan breaks edges that are older than a given duration. Use this
      * to get rid of sensor data which are too old to be useful
@@ -226,11 +385,81 @@ public:
     Pose lookupPose(const std::string& entityName) const;
 
     /**
-     * @todo Remove?
+     * @brief lookupPose returns the pose of a given entity without throwing
+     * @param entity: The handle of the entity
+     * @param pose: Receives the pose if the lookup is successful
+     * @return True if the entity is connected to the world
      */
-    std::vector<std::string> lookupPath(const std::string& from, const std::string& to);
-    tf2::Transform lookupTransform(const std::string& from, const std::string& to);
-    bool canTransform(const std::string& from, const std::string& to);
+    bool lookupPose(EntityHandle entity, Pose& pose) const;
+
+    /**
+     * @brief lookupPose interpolates the pose of a given entity at a past time
+     * from the poses of the evaluations around that time
+     * @param entity: The handle of the entity
+     * @param time: The stamp of interest, e.g. the capture time of an image
+     * @param pose: Receives the pose if the lookup is successful
+     * @return False if the entity was not connected to the world or the time is not covered by the history
+     */
+    bool lookupPose(EntityHandle entity, const ros::Time& time, Pose& pose) const;
+
+    /**
+     * @brief exportPoses copies the states of all entities into a flat table indexed by their handles.
+     * The table is reused, no allocations take place unless entities have been added.
+     * @param table
+     */
+    void exportPoses(PoseTable& table) const;
+
+    /**
+     * @brief exportPoses interpolates the poses of all entities at a past time.
+     * Only the poses and the evaluated flags are set.
+     * @param time
+     * @param table
+     */
+    void exportPoses(const ros::Time& time, PoseTable& table) const;
+
+    /**
+     * @brief snapshot returns the poses of the latest evaluation.
+     * Does not lock the graph, the snapshot stays valid while the next evaluation is running.
+     * @return The latest snapshot, never null
+     */
+    std::shared_ptr<const PoseSnapshot> snapshot() const;
+
+    /**
+     * @brief lookupPath returns the most accurate chain of entities, i.e.
+     * the one with the lowest accumulated variance of its sensor data.
+     * The path leads along the carriers of rigidly attached entities.
+     * @param from
+     * @param to
+     * @return The entities along the path, just the carrier if both share it, empty if there is none
+     */
+    std::vector<std::string> lookupPath(const std::string& from, const std::string& to) const;
+
+    /**
+     * @brief lookupTransform composes the transforms along the most accurate path.
+     * Paths are cached until the topology or the sensor accuracies change.
+     * The queries are thread-safe and run concurrently with each other, but are serialized
+     * against update() and eval(), i.e. they wait for a running evaluation to finish.
+     * Use snapshot() to read the poses without waiting.
+     * @param from
+     * @param to
+     * @return The pose of 'to' in the frame of 'from', identity if there is no path
+     */
+    tf2::Transform lookupTransform(const std::string& from, const std::string& to) const;
+
+    /**
+     * @brief canTransform
+     * @param from
+     * @param to
+     * @return True if there is a chain of sensor data connecting the two entities, false if they are the same
+     */
+    bool canTransform(const std::string& from, const std::string& to) const;
+
+    /**
+     * @brief connectedEntities
+     * @param entity
+     * @return The names of all the entities connected to the given entity (excluding itself)
+     */
+    std::vector<std::string> connectedEntities(const std::string& entity = "world") const;
 
     /**
      * @brief numberOfEdges
@@ -239,10 +468,17 @@ public:
     std::size_t numberOfEdges() const;
 
     /**
-     * @brief eval calculates the pose of every entity in the graph
+     * @brief eval calculates the pose of every entity in the graph.
+     * Only the entities affected by changed measurements since the last evaluation are recalculated.
      */
     void eval();
 
+    /**
+     * @brief topologyVersion
+     * @return A counter that changes whenever an entity or a connection between two entities is added or removed
+     */
+    std::size_t topologyVersion() const;
+
     /**
      * @brief save saves the graph to a given dot file
      * @param filename
@@ -257,20 +493,411 @@ public:
 
     /**
      * @brief clearEvalFlag
-     * Clears the "evaluated" flag of all entites
+     * Clears the "evaluated" flag of all entites, the next evaluation recalculates all of them
      */
     void clearEvalFlag();
 
+protected:
+    /**
+     * @brief addEdge stores an edge in a free slot and adds it to the pair of its vertices
+     * @param info: The edge, source and target have to be set
+     * @return The slot of the new edge
+     */
+    Edge addEdge(const EdgeInfo& info);
+
+    /**
+     * @brief removeEdge removes an edge from its pair and frees its slot.
+     * The pair is removed along with its last edge.
+     * @param edge
+     */
+    void removeEdge(Edge edge);
+
+    /**
+     * @brief markDirty schedules a pair for fusion
+     * @param pair
+     */
+    void markDirty(Pair pair);
+
+    /**
+     * @brief fuseDirtyPairs recalculates the transform of all pairs whose edges changed
+     */
+    void fuseDirtyPairs();
+
+    /**
+     * @brief fusePair fuses the sensor data of a pair with multiple edges
+     * @param info
+     */
+    void fusePair(PairInfo& info);
+
+    /**
+     * @brief removeEdgePair removes the forward and inverse edge of a measurement
+     * @param key: The key of the measurement, copied as the edges are about to be freed
+     */
+    void removeEdgePair(Measurement::Key key);
+
+    /**
+     * @brief rigidBody collects a vertex and the vertices rigidly attached to it
+     * @param vertex
+     * @return The vertex followed by the attached ones
+     */
+    std::vector<Vertex> rigidBody(Vertex vertex) const;
+
+    /**
+     * @brief removeEdgesOf removes the measurements from or to any of the given vertices, matched by their keys
+     * @param vertices
+     */
+    void removeEdgesOf(const std::vector<Vertex>& vertices);
+
+    /**
+     * @brief scheduleExpiry adds an edge to the expiry heap
+     * @param edge: The forward edge of a measurement
+     */
+    void scheduleExpiry(Edge edge);
+
+    /**
+     * @brief updateLifetime derives the lifetime of an edge from the message rate of its sensor
+     * @param info: The forward edge of a measurement
+     * @param stamp: The stamp of the new measurement
+     */
+    void updateLifetime(EdgeInfo& info, const ros::Time& stamp);
+
+    /**
+     * @brief applyMeasurement adds or updates the edges of a single measurement
+     * @param measurement
+     * @return False if one of the entities is missing
+     */
+    bool applyMeasurement(const Measurement& measurement);
+
+    /**
+     * @brief applyMeasurement adds or updates the edges of a single measurement between two vertices
+     * @param measurement
+     * @param from: The source vertex, not rigidly attached
+     * @param to: The target vertex, not rigidly attached
+     */
+    void applyMeasurement(const Measurement& measurement, Vertex from, Vertex to);
+
+    /**
+     * @brief evalVertex calculates the pose of a vertex from the vertices on the lower levels.
+     * Does nothing if neither its pairs nor its sources changed.
+     * @param vertex
+     */
+    void evalVertex(Vertex vertex);
+
+    /**
+     * @brief optimize refines the poses of the reachable vertices by solving the whole graph.
+     * The anchors are fixed, the pose of every other vertex is a variable.
+     */
+    void optimize();
+
+    /**
+     * @brief refine runs Gauss-Seidel sweeps over the reachable vertices until
+     * the poses converged or the refine budget is used up
+     */
+    void refine();
+
+    /**
+     * @brief updateTraversal recalculates the breadth first ordering, the levels
+     * and the islands of the vertices if the topology changed since the last call.
+     * All vertices are marked stale in that case.
+     */
+    void updateTraversal();
+
+    /**
+     * @brief shortestPath runs a dijkstra search weighted by the variance of the pairs
+     * @param start
+     * @param goal
+     * @param pairs: Receives the pairs leading from start to goal
+     * @return True if the goal is reachable
+     */
+    bool shortestPath(Vertex start, Vertex goal, std::vector<Pair>& pairs) const;
+
+    /**
+     * @brief carrierTransform looks up the transform between two vertices along the cached most accurate path
+     * @param from
+     * @param to
+     * @param transform: Receives the pose of 'to' in the frame of 'from'
+     * @return True if there is a path
+     */
+    bool carrierTransform(Vertex from, Vertex to, tf2::Transform& transform) const;
+
+    /**
+     * @brief composePath chains the transforms of the given pairs
+     * @param pairs
+     * @return The composed transform
+     */
+    tf2::Transform composePath(const std::vector<Pair>& pairs) const;
+
+    /**
+     * @brief component finds the connected component of a vertex
+     * @param vertex
+     * @return The representative vertex of the component
+     */
+    Vertex component(Vertex vertex) const;
+
+    /**
+     * @brief uniteComponents merges the components of two vertices
+     * @param a
+     * @param b
+     */
+    void uniteComponents(Vertex a, Vertex b);
+
+    /**
+     * @brief rebuildComponents recalculates the connected components if connections have been removed
+     */
+    void rebuildComponents();
+
+    /**
+     * @brief insertVertex creates the vertex of an entity
+     * @param name
+     * @return The new vertex
+     */
+    Vertex insertVertex(const std::string& name);
+
+    /**
+     * @brief releaseVertex frees the slot of a vertex without any pairs left
+     * @param vertex
+     */
+    void releaseVertex(Vertex vertex);
+
+    /**
+     * @brief carrierOf
+     * @param vertex
+     * @return The vertex representing the given one in the graph, i.e. its carrier if it is rigidly attached
+     */
+    Vertex carrierOf(Vertex vertex) const;
+
+    /**
+     * @brief entityPose derives the pose of rigidly attached entities from their carrier
+     * @param vertex
+     * @param pose: Receives the pose if the entity is connected to the world
+     * @return True if the entity is connected to the world
+     */
+    bool entityPose(Vertex vertex, Pose& pose) const;
+
+    /**
+     * @brief historicPose interpolates the pose of an entity at a past time
+     * @param vertex
+     * @param time
+     * @param pose: Receives the pose if the lookup is successful
+     * @return True if the entity was connected to the world at that time
+     */
+    bool historicPose(Vertex vertex, const ros::Time& time, Pose& pose) const;
+
+    /**
+     * @brief attachedPose expands the pose of a rigidly attached entity
+     * @param vertex
+     * @param carrierPose: The pose of its carrier
+     * @return The pose of the entity
+     */
+    Pose attachedPose(Vertex vertex, const Pose& carrierPose) const;
+
+    /**
+     * @brief recordHistory appends the current poses to the histories of the entities
+     * @param stamp: The time of the evaluation
+     */
+    void recordHistory(const ros::Time& stamp);
+
+    /**
+     * @brief fillPoseTable copies the states of all entities into a table
+     * @param table
+     */
+    void fillPoseTable(PoseTable& table) const;
+
+    /**
+     * @brief publishSnapshot makes the current poses available to the readers of snapshot()
+     * @param stamp: The time of the evaluation
+     */
+    void publishSnapshot(const ros::Time& stamp);
+
+    /**
+     * @brief invalidatePoses clears the "evaluated" flag of all entities but the world and the frozen ones
+     */
+    void invalidatePoses();
+
+    /**
+     * @brief checkAnchors re-arms the frozen entities whose measurements deviate from their pose
+     */
+    void checkAnchors();
+
+    /**
+     * @brief settle freezes a static vertex once its pose stayed within the tolerance long enough
+     * @param vertex
+     * @param previous: The pose prior to the evaluation
+     */
+    void settle(Vertex vertex, const Pose& previous);
+
+    /**
+     * @brief hasFlag
+     * @param vertex
+     * @param flag
+     * @return True if the flag is set on the vertex
+     */
+    bool hasFlag(Vertex vertex, VertexFlag flag) const;
+
+    /**
+     * @brief setFlag sets or clears a flag of a vertex
+     * @param vertex
+     * @param flag
+     * @param enabled
+     */
+    void setFlag(Vertex vertex, VertexFlag flag, bool enabled = true);
+
+    /**
+     * @brief pose
+     * @param vertex
+     * @return The pose of the vertex as stored in the pose table, only valid if evaluated
+     */
+    Pose pose(Vertex vertex) const;
+
+    /**
+     * @brief deviates
+     * @param a
+     * @param b
+     * @return True if the poses differ by more than the static tolerance
+     */
+    bool deviates(const Pose& a, const Pose& b) const;
+
+    /**
+     * @brief vertex
+     * @param symbol: The symbol of an entity
+     * @return The vertex of the entity, -1 if it is not part of the graph
+     */
+    Vertex vertex(Symbol symbol) const;
+
 private:
-    // the graph container containing all our sensor information
-    Graph m_graph;
+    // the vertices, the world is always the first one
+    // removed vertices leave a free slot behind
+    std::vector<VertexInfo> m_vertices;
+    std::vector<Vertex> m_freeVertices;
+
+    // the pose table, i.e. the state of the vertices touched by every evaluation
+    // One array per member, indexed by vertex, such that the evaluation streams through memory.
+    AlignedVector<Position> m_positions; ///< in the world frame
+    AlignedVector<Rotation> m_rotations; ///< in the world frame
+    AlignedVector<int> m_levels; ///< the distance to the world in the traversal
+    AlignedVector<int> m_fuseCounts; ///< the number of fused sources
+    AlignedVector<std::size_t> m_updatePasses; ///< the evaluation pass the pose was last updated in
+    AlignedVector<std::uint8_t> m_flags; ///< combination of VertexFlag
+
+    // the edges, removed edges leave a free slot behind
+    std::vector<EdgeInfo> m_edges;
+    std::vector<Edge> m_freeEdges;
+
+    // the pairs i.e. the aggregated edges between two vertices
+    std::vector<PairInfo> m_pairs;
+    std::vector<Pair> m_freePairs;
+    std::vector<Pair> m_dirtyPairs;
+
+    // filter used to fuse the edges of a pair
+    WeightedMean m_pairFilter;
 
     // keep track of the vertices by name for easy access
     std::map<std::string, Vertex> m_labeledVertex;
 
-    // used to assign unique IDs to vertices
-    int m_count = 0;
+    // the vertices indexed by the id of their symbol, -1 if there is none
+    std::vector<Vertex> m_symbolVertex;
+
+    // the forward and inverse edge of every measurement in the graph
+    std::unordered_map<Measurement::Key, std::pair<Edge, Edge>, Measurement::Key::Hash> m_keyedEdges;
+
+    // min-heap of the edge deadlines, the first edge to expire is on top
+    std::vector<Expiry> m_expiryHeap;
+
+    // buffer reused by update() to fetch the measurements
+    SensorDataList m_measurements;
+
+    // the vertices reachable from the world in breadth first order, starting with the world
+    // the order is valid as long as the topology does not change
+    std::vector<Vertex> m_traversal;
+    std::size_t m_topologyVersion  = 0;
+    std::size_t m_traversalVersion = std::size_t(-1);
+
+    // the index in the traversal at which each level starts, followed by the end of the traversal
+    std::vector<std::size_t> m_levelBegin;
+
+    // the reachable vertices (except the anchors) grouped by island, each island is sorted by level
+    // The islands are the parts of the graph only connected through the world or the frozen static entities.
+    std::vector<Vertex> m_islandVertices;
+    std::vector<std::size_t> m_islandBegin; ///< the index at which each island starts, followed by the end
+    std::size_t m_largestIsland = 0; ///< the number of vertices of the largest island
 
-    // decay duration i.e. the time after which edges with no activity are removed
+    // counts the evaluations
+    std::size_t m_evalPass = 0;
+
+    /**
+     * @brief The CachedPath struct
+     * A path returned by lookupTransform
+     */
+    struct CachedPath
+    {
+        std::vector<Pair> pairs; ///< the pairs along the path, empty if not connected
+        tf2::Transform transform; ///< the composed transform
+        std::size_t weightVersion = 0; ///< the pair accuracies the path is based on
+        std::size_t valueVersion  = 0; ///< the pair transforms the transform is based on
+    };
+
+    // cached paths keyed by start and goal
+    // The cache is dropped when the topology changes.
+    // It is shared by the concurrent queries and has its own lock.
+    mutable std::unordered_map<std::uint64_t, CachedPath> m_pathCache;
+    mutable std::size_t m_pathCacheVersion = 0;
+    mutable std::mutex m_pathCacheMutex;
+
+    std::size_t m_pairWeightVersion = 0;
+    std::size_t m_pairValueVersion  = 0;
+
+    // union-find of the connected components
+    // Connections can only be merged, the components are rebuilt after removals
+    std::vector<Vertex> m_componentParent;
+    std::vector<int> m_componentRank;
+    bool m_componentsOutdated = false;
+
+    // the workers used to evaluate the levels in parallel, null if disabled
+    std::unique_ptr<ThreadPool> m_pool;
+
+    // levels with fewer vertices are evaluated on the calling thread
+    std::size_t m_minParallelCount = 8;
+
+    // the least-squares solver used in the optimize mode
+    Options::EvalMode m_evalMode = Options::EvalMode::Greedy;
+    int m_solverIterations       = 2;
+    PoseGraphSolver m_solver;
+    std::vector<int> m_solverIndex; ///< the index of each vertex in the solver, -1 if not reachable
+
+    // the refinement sweeps of the greedy evaluation
+    double m_refineBudget         = 0.0; ///< in seconds, 0 if disabled
+    double m_refineTolerance      = 1e-6; ///< changes below the tolerance (in meters or radians) count as converged
+    std::size_t m_refineClockSkip = 64; ///< the number of vertices refined between two reads of the clock
+
+    // the number of poses kept per entity
+    std::size_t m_historySize = 120;
+
+    // Frozen static entities are anchors, i.e. they act like the world during the evaluation
+    double m_staticTolerance      = 0.05;
+    double m_staticAngleTolerance = 0.087; ///< about 5 degrees
+    int m_staticSettleCount       = 10; ///< the number of evaluations until a static entity is frozen
+    std::atomic<bool> m_anchorsChanged{ false };
+
+    // decay duration i.e. the minimum time after which edges with no activity are removed
     ros::Duration m_decayDuration = ros::Duration(0.25);
+
+    // the lifetime of the edges follows the rate of their sensors
+    // Steadily reporting sensors get a longer lifetime, such that a late or dropped message
+    // does not remove and re-add their edges (and thus change the topology).
+    double m_lifetimeFactor     = 3.0; ///< the number of average intervals without data
+    double m_maxLifetime        = 2.0; ///< in seconds
+    double m_lifetimeHysteresis = 2.0; ///< the lifetime multiplier of the established edges
+    int m_establishedArrivals   = 10; ///< the number of measurements after which an edge is established
+    double m_intervalAlpha      = 0.2; ///< smoothing of the average interval
+
+    // the latest snapshot is swapped atomically
+    // The previous ones are refilled once all of their readers have released them.
+    std::shared_ptr<const PoseSnapshot> m_snapshot;
+    std::array<std::shared_ptr<PoseSnapshot>, 3> m_snapshotBuffers;
+    std::size_t m_publishedBuffer = 0;
+
+    // The queries share the graph, the mutations (and the evaluation) own it exclusively
+    using ReadLock  = boost::shared_lock<boost::shared_mutex>;
+    using WriteLock = boost::unique_lock<boost::shared_mutex>;
+    mutable boost::shared_mutex m_mutex;
 };
@@ -25,15 +25,7 @@
 
 TransformGraphBroadcaster::TransformGraphBroadcaster(const Config& config)
 {
-    // load entities
-    for (const auto& entity : config.entities())
-    {
-        m_entities[entity.name] = entity;
-
-        // cfg filter
-        m_filters[entity.name].setTimeout(ros::Duration(config.options().decayDuration));
-        m_filters[entity.name].setAlpha(entity.filterConfig.alpha);
-    }
+    m_filterTimeout = ros::Duration(config.options().decayDuration);
 
     m_publishWorldSensors  = config.options().publishWorldSensors;
     m_publishEntitySensors = config.options().publishEntitySensors;
@@ -42,55 +34,80 @@ TransformGraphBroadcaster::TransformGraphBroadcaster(const Config& config)
     // create publisher
     m_dotGraphPublisher = m_node.advertise<std_msgs::String>("transformgraph", 10);
 
+    // load entities
+    for (const auto& entity : config.entities())
+        addEntity(entity);
+}
+
+void TransformGraphBroadcaster::addEntity(const Entity& entity)
+{
+    m_entities[entity.name] = entity;
+
     // create publish as topic publishers
-    if (m_publishPoseTopics)
-    {
-        for (const auto& entity : config.entities())
-            m_publishers[entity.name] = m_node.advertise<atlas::FusedPose>("atlas/fusedposes/" + entity.name, 10);
-    }
+    if (m_publishPoseTopics && m_publishers.count(entity.name) == 0)
+        m_publishers[entity.name] = m_node.advertise<atlas::FusedPose>("atlas/fusedposes/" + entity.name, 10);
+
+    // a replaced entity is set up again on the next broadcast
+    resetEntityState(entity.name);
+}
+
+void TransformGraphBroadcaster::removeEntity(const std::string& name)
+{
+    m_entities.erase(name);
+    m_publishers.erase(name);
+
+    // the handle may be recycled by the graph
+    resetEntityState(name);
 }
 
 void TransformGraphBroadcaster::broadcast(const TransformGraph& graph)
 {
-    auto entityNames = graph.entities();
-    for (const auto& entityName : entityNames)
+    // the result of the latest evaluation, no lookups per entity
+    const auto snapshot = graph.snapshot();
+    const auto& poses   = snapshot->poses;
+
+    // entities added since the last broadcast
+    if (m_states.size() < poses.size())
+        m_states.resize(poses.size());
+
+    for (std::size_t handle = 0; handle < poses.size(); ++handle)
     {
-        Pose pose;
-        try
+        const auto& entry = poses[handle];
+        auto& state       = m_states[handle];
+
+        // no lookup possible
+        if (!entry.evaluated)
+            continue;
+
+        // new or recycled handle
+        if (state.name.empty())
+            initEntityState(state, graph.entityName(TransformGraph::EntityHandle(handle)));
+
+        // filter the pose
+        state.filter.addPose(entry.pose);
+        const auto pose = state.filter.pose();
+
+        // broadcast the entity's pose in world frame
+        if (state.name != "world")
+            broadcast("world", state.name, pose);
+
+        if (m_publishMarkers)
         {
-            // this method throws if a lookup is not possible
-            pose = graph.lookupPose(entityName);
-
-            // filter the pose
-            m_filters[entityName].addPose(pose);
-            pose = m_filters[entityName].pose();
-
-            // broadcast the entity's pose in world frame
-            if (entityName != "world")
-                broadcast("world", entityName, pose);
-
-            if (m_publishMarkers)
-            {
-                // show the markers attached to that entity
-                for (const auto& marker : m_entities[entityName].markers)
-                    broadcast(entityName, "Marker " + std::to_string(marker.id), marker.transf);
-            }
-
-            if (m_publishEntitySensors)
-            {
-                // show the sensors attached to that entity
-                for (const auto& sensor : m_entities[entityName].sensors)
-                    broadcast(entityName, entityName + "-" + sensor.name, sensor.transf);
-            }
-
-            if (m_publishPoseTopics)
-            {
-                broadcast(entityName, pose, graph.fuseCount(entityName));
-            }
+            // show the markers attached to that entity
+            for (const auto& marker : state.markers)
+                broadcast(state.name, marker.frame, marker.transf);
         }
-        catch (const std::string&)
+
+        if (m_publishEntitySensors)
         {
-            // no lookup possible
+            // show the sensors attached to that entity
+            for (const auto& sensor : state.sensors)
+                broadcast(state.name, sensor.frame, sensor.transf);
+        }
+
+        if (m_publishPoseTopics)
+        {
+            broadcast(state.publisher, pose, entry.fuseCount);
         }
     }
 
@@ -102,6 +119,42 @@ void TransformGraphBroadcaster::broadcast(const TransformGraph& graph)
     }
 }
 
+void TransformGraphBroadcaster::initEntityState(EntityState& state, const std::string& name)
+{
+    state.name = name;
+
+    auto publisher = m_publishers.find(name);
+    if (publisher != m_publishers.end())
+        state.publisher = publisher->second;
+
+    // entities without configuration (e.g. the world) use the default filter
+    auto itr = m_entities.find(name);
+    if (itr == m_entities.end())
+        return;
+
+    const auto& entity = itr->second;
+
+    // cfg filter
+    state.filter.setTimeout(m_filterTimeout);
+    state.filter.setAlpha(entity.filterConfig.alpha);
+
+    // the frame names are built once
+    for (const auto& marker : entity.markers)
+        state.markers.push_back({ "Marker " + std::to_string(marker.id), marker.transf });
+
+    for (const auto& sensor : entity.sensors)
+        state.sensors.push_back({ name + "-" + sensor.name, sensor.transf });
+}
+
+void TransformGraphBroadcaster::resetEntityState(const std::string& name)
+{
+    for (auto& state : m_states)
+    {
+        if (state.name == name)
+            state = EntityState();
+    }
+}
+
 void TransformGraphBroadcaster::broadcast(const std::string& frame, const std::string& child, const tf2::Transform transf)
 {
     geometry_msgs::TransformStamped transform;
@@ -140,7 +193,7 @@ void TransformGraphBroadcaster::broadcast(const std::string& frame, const std::s
     m_tfbc.sendTransform(transform);
 }
 
-void TransformGraphBroadcaster::broadcast(const std::string& entity, const Pose pose, int fuseCount)
+void TransformGraphBroadcaster::broadcast(const ros::Publisher& publisher, const Pose pose, int fuseCount)
 {
     atlas::FusedPose fusedPoseMsg;
     fusedPoseMsg.pose.header.stamp    = ros::Time::now();
@@ -156,5 +209,5 @@ void TransformGraphBroadcaster::broadcast(const std::string& entity, const Pose
     fusedPoseMsg.pose.pose.position.y = pose.pos.y();
     fusedPoseMsg.pose.pose.position.z = pose.pos.z();
 
-    m_publishers[entity].publish(fusedPoseMsg);
+    publisher.publish(fusedPoseMsg);
 }
@@ -40,10 +40,58 @@ public:
      */
     void broadcast(const TransformGraph& graph);
 
+    /**
+     * @brief addEntity publishes an entity added at runtime, replaces an entity with the same name
+     * @param entity
+     */
+    void addEntity(const Entity& entity);
+
+    /**
+     * @brief removeEntity stops publishing an entity
+     * @param name
+     */
+    void removeEntity(const std::string& name);
+
 protected:
     void broadcast(const std::string& frame, const std::string& child, const tf2::Transform transf);
     void broadcast(const std::string& frame, const std::string& child, const Pose pose);
-    void broadcast(const std::string& entity, const Pose pose, int fuseCount);
+    void broadcast(const ros::Publisher& publisher, const Pose pose, int fuseCount);
+
+    /**
+     * @brief The Attachment struct
+     * A frame rigidly attached to an entity (e.g. a marker or a sensor)
+     */
+    struct Attachment
+    {
+        std::string frame; ///< the name of the published frame
+        tf2::Transform transf; ///< the transformation relative to the entity
+    };
+
+    /**
+     * @brief The EntityState struct
+     * Everything needed to publish an entity, indexed by its handle in the graph
+     */
+    struct EntityState
+    {
+        std::string name;
+        ExplonentialMovingAverageFilter filter;
+        std::vector<Attachment> markers;
+        std::vector<Attachment> sensors;
+        ros::Publisher publisher;
+    };
+
+    /**
+     * @brief initEntityState sets up the state of an entity that has not been published before
+     * @param state
+     * @param name: The name of the entity
+     */
+    void initEntityState(EntityState& state, const std::string& name);
+
+    /**
+     * @brief resetEntityState clears the state of an entity, it is set up again once the entity is evaluated
+     * @param name
+     */
+    void resetEntityState(const std::string& name);
 
 private:
     tf2_ros::TransformBroadcaster m_tfbc;
@@ -51,8 +99,11 @@ private:
     std::map<std::string, ros::Publisher> m_publishers;
     ros::NodeHandle m_node;
 
-    std::map<std::string, ExplonentialMovingAverageFilter> m_filters;
     std::map<std::string, Entity> m_entities;
+    ros::Duration m_filterTimeout;
+
+    // the states share the handles of the graph
+    std::vector<EntityState> m_states;
 
     bool m_publishMarkers       = true;
     bool m_publishEntitySensors = true;
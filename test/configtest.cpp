@@ -10,6 +10,8 @@ const std::string yamlInput = //
     "\n"
     "  # graph settings\n"
     "  decayDuration: 1.0 # seconds\n"
+    "  evalMode: Optimize\n"
+    "  solverIterations: 3\n"
     "\n"
     "  # transform publisher settings\n"
     "  publishMarkers: false\n"
@@ -50,6 +52,7 @@ const std::string yamlInput = //
     "  # This entity is used to detect the position of marker 0\n"
     "  # It has no physical meaning\n"
     "  - entity: Marker0Wrapper\n"
+    "    static: true\n"
     "    markers:\n"
     "    - marker: 0\n"
     "      transform: {origin: [7, 8, 9], rot: [1, 0, 1, 0]}\n"
@@ -68,6 +71,8 @@ TEST(Config, options)
     ASSERT_EQ(1.0, config.options().decayDuration);
     ASSERT_EQ(1.0, config.options().decayDuration);
     ASSERT_EQ(1.0, config.options().loopRate);
+    ASSERT_TRUE(config.options().evalMode == Options::EvalMode::Optimize);
+    ASSERT_EQ(3, config.options().solverIterations);
 }
 
 TEST(Config, entities)
@@ -88,6 +93,10 @@ TEST(Config, entities)
     // marker id check
     ASSERT_EQ(0, config.entities()[3].markers[0].id);
 
+    // static check
+    ASSERT_FALSE(config.entities()[1].isStatic);
+    ASSERT_TRUE(config.entities()[3].isStatic);
+
     // sensor check
     ASSERT_EQ("optitrack0", config.entities()[0].sensors[0].name);
     ASSERT_EQ("optitrack1", config.entities()[0].sensors[1].name);
@@ -119,3 +128,80 @@ TEST(Config, transform)
     transf.setRotation({ 0, 0.707, 0.707, 0 });
     ASSERT_TRUE(transfEq(transf, config.entities()[1].sensors[0].transf));
 }
+
+TEST(Config, rigidAttachment)
+{
+    Config config;
+    config.loadFromString( //
+        "entities:\n"
+        "  - entity: carrier\n"
+        "  - entity: payload\n"
+        "    attachedTo: gimbal\n"
+        "    attachTransform: {origin: [1, 0, 0], rot: [0, 0, 0, 1]}\n"
+        "  - entity: gimbal\n"
+        "    attachedTo: carrier\n"
+        "    attachTransform: {origin: [0, 0, -1], rot: [0, 0, 0.707107, 0.707107]}\n"
+        "  - entity: loop\n"
+        "    attachedTo: loop\n");
+
+    ASSERT_EQ("gimbal", config.entities()[1].attachedTo);
+
+    // free entities carry themselves
+    ASSERT_EQ("carrier", config.resolveRigid("carrier").carrier);
+    ASSERT_TRUE(transfEq(tf2::Transform::getIdentity(), config.resolveRigid("carrier").transform));
+    ASSERT_EQ("loop", config.resolveRigid("loop").carrier);
+
+    // the chain is composed
+    tf2::Transform transf;
+    transf.setOrigin({ 0, 1, -1 });
+    transf.setRotation({ 0, 0, 0.707107, 0.707107 });
+
+    ASSERT_EQ("carrier", config.resolveRigid("payload").carrier);
+    ASSERT_TRUE(transfEq(transf, config.resolveRigid("payload").transform));
+
+    // the attached entities are collected along the chain
+    ASSERT_EQ((std::vector<std::string>{ "gimbal", "payload" }), config.attachedEntities("carrier"));
+    ASSERT_EQ(std::vector<std::string>{ "payload" }, config.attachedEntities("gimbal"));
+    ASSERT_TRUE(config.attachedEntities("loop").empty());
+}
+
+TEST(Config, runtimeEntities)
+{
+    Config config;
+    config.loadFromString(yamlInput);
+
+    Entity entity;
+    ASSERT_FALSE(config.entityFromString("- not an entity", entity));
+    ASSERT_FALSE(config.entityFromString("{ entity: [", entity));
+
+    ASSERT_TRUE(config.entityFromString( //
+        "entity: ardrone2\n"
+        "markers:\n"
+        "- marker: 2\n"
+        "  transform: {origin: [1, 0, 0], rot: [0, 0, 0, 1]}\n",
+        entity));
+
+    ASSERT_EQ("ardrone2", entity.name);
+    ASSERT_EQ(2, entity.markers[0].id);
+
+    config.addEntity(entity);
+    ASSERT_EQ(5, config.entities().size());
+
+    // replaced by name
+    config.addEntity(entity);
+    ASSERT_EQ(5, config.entities().size());
+
+    ASSERT_TRUE(config.entityFromString( //
+        "entity: payload\n"
+        "attachedTo: ardrone2\n",
+        entity));
+    config.addEntity(entity);
+
+    ASSERT_EQ("ardrone2", config.resolveRigid("payload").carrier);
+    ASSERT_EQ(std::vector<std::string>{ "payload" }, config.attachedEntities("ardrone2"));
+
+    ASSERT_TRUE(config.removeEntity("ardrone2"));
+    ASSERT_FALSE(config.removeEntity("ardrone2"));
+    ASSERT_EQ(5, config.entities().size());
+    ASSERT_EQ("payload", config.resolveRigid("payload").carrier);
+}
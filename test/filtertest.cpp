@@ -86,3 +86,24 @@ TEST(Filters, expMovingAverage)
     expected = tf2::Vector3{ 1, 1, 1 };
     ASSERT_EQ(expected, result);
 }
+
+TEST(Filters, singlePrecision)
+{
+    WeightedMeanT<float> mean;
+    mean.addPose({ { 1, 1, 1 }, Eigen::Quaternionf::Identity() }, 0.5f);
+    mean.addPose({ { 1, 3, 1 }, Eigen::Quaternionf(Eigen::AngleAxisf(0.2f, Eigen::Vector3f::UnitZ())) }, 0.5f);
+
+    const auto pose = mean.weightedMeanPose().toPose();
+    ASSERT_TRUE(vec3Eq({ 1, 2, 1 }, pose.pos));
+    ASSERT_NEAR(0.1, pose.rot.angleShortestPath(tf2::Quaternion::getIdentity()), 1e-4);
+
+    // the same results as in double precision
+    ExplonentialMovingAverageFilterT<float> filter(0.5);
+    filter.addVec3({ 1, 1, 1 });
+    filter.addVec3({ 0, 0, 0 });
+    ASSERT_EQ(tf2::Vector3(0.5, 0.5, 0.5), filter.vec3());
+
+    filter.addQuat(tf2::Quaternion({ 0, 0, 1 }, 0.4));
+    filter.addQuat(tf2::Quaternion::getIdentity());
+    ASSERT_TRUE(quatEq(tf2::Quaternion({ 0, 0, 1 }, 0.2), filter.quat()));
+}
@@ -3,7 +3,9 @@
 #include <boost/graph/dijkstra_shortest_paths.hpp>
 #include <boost/graph/graph_traits.hpp>
 
+#include <atomic>
 #include <chrono>
+#include <set>
 #include <thread>
 
 #include "../src/transformgraph.h"
@@ -156,3 +158,881 @@ TEST(Graphs, expectThrow)
     auto q = tf2::Quaternion({ 0, 1, 0 }, angles::from_degrees(90 + 28)) * tf2::Quaternion({ 0, 0, 1 }, angles::from_degrees(270));
     std::cout << q << std::endl;
 }
+
+TEST(Graphs, edgeSlots)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.addEntity("B");
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 1, 0 } });
+    graph.updateSensorData({ { "A", "B", "cam0", 0 }, { 1, 0, 0 } });
+    ASSERT_EQ(4, graph.numberOfEdges());
+
+    // freed slots are reused by new edges
+    graph.removeAllEdges("B");
+    ASSERT_EQ(2, graph.numberOfEdges());
+    ASSERT_FALSE(graph.canTransform("world", "B"));
+
+    graph.updateSensorData({ { "A", "B", "cam0", 0 }, { 1, 0, 0 } });
+    ASSERT_EQ(4, graph.numberOfEdges());
+    ASSERT_TRUE(pathEq({ "world", "A", "B" }, graph.lookupPath("world", "B")));
+
+    graph.eval();
+    ASSERT_TRUE(poseEq({ { 2, 1, 0 }, { 0, 0, 0, 1 } }, graph.lookupPose("B")));
+}
+
+TEST(Graphs, updateInPlace)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 1, 0 } });
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 2, 1, 0 } });
+    ASSERT_EQ(2, graph.numberOfEdges());
+
+    graph.eval();
+    ASSERT_TRUE(poseEq({ { 2, 1, 0 }, { 0, 0, 0, 1 } }, graph.lookupPose("A")));
+
+    graph.removeEdgesByKey({ "world", "A", "optitrack", -1 });
+    ASSERT_EQ(0, graph.numberOfEdges());
+}
+
+TEST(Graphs, expireUpdated)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.addEntity("B");
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 1, 0 } });
+    graph.updateSensorData({ { "world", "B", "optitrack", -2 }, { 1, 1, 0 } });
+
+    // refresh A, only B is expected to expire
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // sleep for 20ms
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 1, 0 } });
+    graph.removeEdgesOlderThan(ros::Duration(10.0 / 1000.0)); // older than 10ms
+
+    ASSERT_TRUE(graph.canTransform("world", "A"));
+    ASSERT_FALSE(graph.canTransform("world", "B"));
+    ASSERT_EQ(2, graph.numberOfEdges());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // sleep for 20ms
+    graph.removeEdgesOlderThan(ros::Duration(10.0 / 1000.0)); // older than 10ms
+
+    ASSERT_EQ(0, graph.numberOfEdges());
+}
+
+TEST(Graphs, batchUpdate)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.addEntity("B");
+
+    SensorDataList measurements = {
+        { { "world", "A", "optitrack", -1 }, { 1, 1, 0 } },
+        { { "A", "B", "cam0", 0 }, { 1, 0, 0 } },
+        { { "A", "X", "cam0", 1 }, { 1, 0, 0 } }, // missing entity
+        { { "world", "A", "optitrack", -1 }, { 2, 1, 0 } }, // repeated key
+    };
+
+    graph.updateSensorData(measurements);
+    ASSERT_EQ(4, graph.numberOfEdges());
+
+    graph.eval();
+    ASSERT_TRUE(poseEq({ { 2, 1, 0 }, { 0, 0, 0, 1 } }, graph.lookupPose("A")));
+    ASSERT_TRUE(poseEq({ { 3, 1, 0 }, { 0, 0, 0, 1 } }, graph.lookupPose("B")));
+}
+
+TEST(Graphs, pairFusion)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+
+    // two markers of the same board seen by the same camera
+    graph.updateSensorData({ { "world", "A", "cam0", 0 }, { 1, 0, 0 }, 1.0 });
+    graph.updateSensorData({ { "world", "A", "cam0", 1 }, { 3, 0, 0 }, 3.0 });
+    ASSERT_EQ(4, graph.numberOfEdges());
+
+    graph.eval();
+    ASSERT_EQ(2, graph.fuseCount("A"));
+    ASSERT_TRUE(poseEq({ { 1.5, 0, 0 }, { 0, 0, 0, 1 } }, graph.lookupPose("A")));
+
+    // the pair follows its edges
+    graph.updateSensorData({ { "world", "A", "cam0", 1 }, { 1, 0, 0 }, 3.0 });
+    graph.eval();
+    ASSERT_TRUE(poseEq({ { 1, 0, 0 }, { 0, 0, 0, 1 } }, graph.lookupPose("A")));
+
+    graph.removeEdgesByKey({ "world", "A", "cam0", 0 });
+    graph.eval();
+    ASSERT_EQ(1, graph.fuseCount("A"));
+}
+
+TEST(Graphs, topologyVersion)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.addEntity("B");
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 1, 0 } });
+
+    auto version = graph.topologyVersion();
+
+    // value only updates do not change the topology
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 2, 1, 0 } });
+    graph.updateSensorData({ { "world", "A", "cam0", 0 }, { 2, 1, 0 } });
+    ASSERT_EQ(version, graph.topologyVersion());
+
+    graph.eval();
+    ASSERT_TRUE(poseEq({ { 2, 1, 0 }, { 0, 0, 0, 1 } }, graph.lookupPose("A")));
+
+    // a new connection does
+    graph.updateSensorData({ { "A", "B", "cam0", 1 }, { 1, 0, 0 } });
+    ASSERT_NE(version, graph.topologyVersion());
+
+    graph.eval();
+    ASSERT_TRUE(poseEq({ { 3, 1, 0 }, { 0, 0, 0, 1 } }, graph.lookupPose("B")));
+}
+
+TEST(Graphs, incrementalEval)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.addEntity("B");
+    graph.addEntity("C");
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 0, 0 } });
+    graph.updateSensorData({ { "A", "B", "cam0", 0 }, { 0, 1, 0 } });
+    graph.updateSensorData({ { "world", "C", "optitrack", -2 }, { 0, 0, 1 } });
+    graph.eval();
+
+    ASSERT_TRUE(poseEq({ { 1, 1, 0 }, { 0, 0, 0, 1 } }, graph.lookupPose("B")));
+
+    // changes propagate down to the dependent vertices
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 2, 0, 0 } });
+    graph.eval();
+
+    ASSERT_TRUE(poseEq({ { 2, 0, 0 }, { 0, 0, 0, 1 } }, graph.lookupPose("A")));
+    ASSERT_TRUE(poseEq({ { 2, 1, 0 }, { 0, 0, 0, 1 } }, graph.lookupPose("B")));
+    ASSERT_TRUE(poseEq({ { 0, 0, 1 }, { 0, 0, 0, 1 } }, graph.lookupPose("C")));
+    ASSERT_EQ(1, graph.fuseCount("C"));
+
+    // unreachable vertices are no longer evaluated
+    graph.removeEdgesByKey({ "world", "A", "optitrack", -1 });
+    graph.eval();
+
+    EXPECT_ANY_THROW(graph.lookupPose("A"));
+    EXPECT_ANY_THROW(graph.lookupPose("B"));
+    ASSERT_TRUE(poseEq({ { 0, 0, 1 }, { 0, 0, 0, 1 } }, graph.lookupPose("C")));
+}
+
+TEST(Graphs, parallelEval)
+{
+    TransformGraph serial;
+    TransformGraph parallel;
+    parallel.setEvalThreads(4);
+
+    for (auto graph : { &serial, &parallel })
+    {
+        for (int i = 0; i < 64; ++i)
+        {
+            const auto drone  = "drone" + std::to_string(i);
+            const auto marker = "marker" + std::to_string(i % 16);
+
+            graph->addEntity(drone);
+            graph->addEntity(marker);
+
+            graph->updateSensorData({ { "world", drone, "optitrack", i }, { double(i), 1, 0 }, { 0, 0, 0, 1 }, 1.0 + i });
+            graph->updateSensorData({ { drone, marker, "cam0", i }, { 0, double(i), 1 }, tf2::Quaternion({ 0, 0, 1 }, 0.1 * i), 1.0 });
+        }
+
+        graph->eval();
+    }
+
+    for (const auto& entity : serial.entities())
+    {
+        ASSERT_EQ(serial.fuseCount(entity), parallel.fuseCount(entity));
+        ASSERT_TRUE(poseEq(serial.lookupPose(entity), parallel.lookupPose(entity)));
+    }
+}
+
+TEST(Graphs, islandEval)
+{
+    TransformGraph serial;
+    TransformGraph parallel;
+    parallel.setEvalThreads(3);
+
+    // separate flight cells, only connected through the world
+    for (auto graph : { &serial, &parallel })
+    {
+        for (int cell = 0; cell < 5; ++cell)
+        {
+            std::string previous = "world";
+
+            for (int i = 0; i < 4 + cell; ++i)
+            {
+                const auto drone = "cell" + std::to_string(cell) + "drone" + std::to_string(i);
+                graph->addEntity(drone);
+                graph->updateSensorData({ { previous, drone, "cam0", i }, { 1, double(cell), 0 }, tf2::Quaternion({ 1, 0, 0 }, 0.2), 1.0 });
+                previous = drone;
+            }
+        }
+
+        // not connected to the world at all
+        graph->addEntity("lost0");
+        graph->addEntity("lost1");
+        graph->updateSensorData({ { "lost0", "lost1", "cam0", 0 }, { 1, 0, 0 } });
+
+        graph->eval();
+    }
+
+    EXPECT_ANY_THROW(parallel.lookupPose("lost1"));
+
+    for (const auto& entity : serial.entities())
+    {
+        if (entity.find("lost") == 0)
+            continue;
+
+        ASSERT_EQ(serial.fuseCount(entity), parallel.fuseCount(entity));
+        ASSERT_TRUE(poseEq(serial.lookupPose(entity), parallel.lookupPose(entity)));
+    }
+}
+
+TEST(Graphs, connectivity)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.addEntity("B");
+    graph.addEntity("C");
+    graph.addEntity("D");
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 1, 0 } });
+    graph.updateSensorData({ { "A", "B", "cam0", 0 }, { 1, 0, 0 } });
+    graph.updateSensorData({ { "C", "D", "cam0", 1 }, { 1, 0, 0 } });
+
+    ASSERT_TRUE(graph.canTransform("world", "B"));
+    ASSERT_TRUE(graph.canTransform("D", "C"));
+    ASSERT_FALSE(graph.canTransform("world", "C"));
+    ASSERT_FALSE(graph.canTransform("world", "unknown"));
+    ASSERT_FALSE(graph.canTransform("A", "A"));
+    ASSERT_FALSE(graph.canTransform("world", "world"));
+    ASSERT_TRUE(pathEq({ "A", "B" }, graph.connectedEntities()));
+
+    // joining both components
+    graph.updateSensorData({ { "B", "C", "cam1", 2 }, { 1, 0, 0 } });
+    ASSERT_TRUE(graph.canTransform("world", "D"));
+    ASSERT_EQ(4, graph.connectedEntities("D").size());
+
+    // splitting them up again
+    graph.removeEdgesByKey({ "A", "B", "cam0", 0 });
+    ASSERT_TRUE(graph.canTransform("world", "A"));
+    ASSERT_FALSE(graph.canTransform("world", "B"));
+    ASSERT_TRUE(graph.canTransform("B", "D"));
+    ASSERT_TRUE(pathEq({ "A" }, graph.connectedEntities("world")));
+}
+
+TEST(Graphs, lookupTransform)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.addEntity("B");
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 1, 0 }, tf2::Quaternion({ 0, 0, 1 }, angles::from_degrees(90)), 1.0 });
+    graph.updateSensorData({ { "A", "B", "cam0", 0 }, { 1, 0, 0 }, tf2::Quaternion(0, 0, 0, 1), 1.0 });
+
+    // the accurate detour is preferred over the noisy direct link
+    graph.updateSensorData({ { "world", "B", "cam1", 1 }, { 5, 5, 0 }, tf2::Quaternion(0, 0, 0, 1), 10.0 });
+    ASSERT_TRUE(pathEq({ "world", "A", "B" }, graph.lookupPath("world", "B")));
+
+    auto transform = graph.lookupTransform("world", "B");
+    ASSERT_TRUE(poseEq({ { 1, 2, 0 }, tf2::Quaternion({ 0, 0, 1 }, angles::from_degrees(90)) }, { transform.getOrigin(), transform.getRotation() }));
+
+    // the inverse direction
+    transform = graph.lookupTransform("B", "world").inverse();
+    ASSERT_TRUE(poseEq({ { 1, 2, 0 }, tf2::Quaternion({ 0, 0, 1 }, angles::from_degrees(90)) }, { transform.getOrigin(), transform.getRotation() }));
+
+    // updated values are picked up by the cached path
+    graph.updateSensorData({ { "A", "B", "cam0", 0 }, { 2, 0, 0 }, tf2::Quaternion(0, 0, 0, 1), 1.0 });
+    transform = graph.lookupTransform("world", "B");
+    ASSERT_TRUE(poseEq({ { 1, 3, 0 }, tf2::Quaternion({ 0, 0, 1 }, angles::from_degrees(90)) }, { transform.getOrigin(), transform.getRotation() }));
+
+    // the direct link becomes the better choice
+    graph.updateSensorData({ { "world", "B", "cam1", 1 }, { 5, 5, 0 }, tf2::Quaternion(0, 0, 0, 1), 0.1 });
+    transform = graph.lookupTransform("world", "B");
+    ASSERT_TRUE(poseEq({ { 5, 5, 0 }, { 0, 0, 0, 1 } }, { transform.getOrigin(), transform.getRotation() }));
+
+    // no path
+    graph.removeAllEdges("B");
+    ASSERT_FALSE(graph.canTransform("world", "B"));
+    transform = graph.lookupTransform("world", "B");
+    ASSERT_TRUE(poseEq({ { 0, 0, 0 }, { 0, 0, 0, 1 } }, { transform.getOrigin(), transform.getRotation() }));
+}
+
+TEST(Graphs, concurrentQueries)
+{
+    TransformGraph graph;
+    graph.setEvalThreads(2);
+
+    for (int i = 0; i < 10; ++i)
+        graph.addEntity("drone" + std::to_string(i));
+
+    std::atomic<bool> done(false);
+    std::atomic<int> failures(0);
+
+    // the queries run while the graph keeps changing
+    std::vector<std::thread> queries;
+    for (int t = 0; t < 4; ++t)
+    {
+        queries.emplace_back([&graph, &done, &failures, t]() {
+            while (!done)
+            {
+                const auto from = "drone" + std::to_string(t);
+
+                if (graph.canTransform(from, "drone9"))
+                {
+                    graph.lookupPath(from, "drone9");
+                    graph.lookupTransform(from, "drone9");
+                }
+
+                if (graph.lookupTransform(from, from).getOrigin().length() != 0.0)
+                    failures++;
+
+                // the world is part of every snapshot
+                const auto snapshot = graph.snapshot();
+                if (snapshot->poses.empty() || !snapshot->poses[0].evaluated)
+                    failures++;
+            }
+        });
+    }
+
+    for (int round = 0; round < 200; ++round)
+    {
+        for (int i = 0; i < 10; ++i)
+        {
+            const auto previous = i ? "drone" + std::to_string(i - 1) : std::string("world");
+            graph.updateSensorData({ { previous, "drone" + std::to_string(i), "cam0", i }, { 1, double(round), 0 } });
+        }
+
+        graph.eval();
+
+        if (round % 10 == 0)
+            graph.removeAllEdges("drone5");
+    }
+
+    done = true;
+    for (auto& thread : queries)
+        thread.join();
+
+    ASSERT_EQ(0, failures);
+    ASSERT_TRUE(pathEq({ "drone0", "drone1", "drone2" }, graph.lookupPath("drone0", "drone2")));
+}
+
+TEST(Graphs, exportPoses)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.addEntity("B");
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 1, 0 } });
+    graph.eval();
+
+    const auto a = graph.entityHandle("A");
+    const auto b = graph.entityHandle("B");
+    ASSERT_EQ(-1, graph.entityHandle("unknown"));
+    ASSERT_EQ("B", graph.entityName(b));
+
+    Pose pose;
+    ASSERT_TRUE(graph.lookupPose(a, pose));
+    ASSERT_TRUE(poseEq({ { 1, 1, 0 }, { 0, 0, 0, 1 } }, pose));
+    ASSERT_FALSE(graph.lookupPose(b, pose));
+    ASSERT_FALSE(graph.lookupPose(-1, pose));
+
+    TransformGraph::PoseTable table;
+    graph.exportPoses(table);
+    ASSERT_EQ(3, table.size());
+
+    ASSERT_TRUE(table[a].evaluated);
+    ASSERT_EQ(1, table[a].level);
+    ASSERT_EQ(1, table[a].fuseCount);
+    ASSERT_TRUE(poseEq({ { 1, 1, 0 }, { 0, 0, 0, 1 } }, table[a].pose));
+
+    ASSERT_FALSE(table[b].evaluated);
+    ASSERT_EQ(-1, table[b].level);
+
+    // the table is reused
+    const auto data = table.data();
+    graph.updateSensorData({ { "A", "B", "cam0", 0 }, { 1, 0, 0 } });
+    graph.eval();
+    graph.exportPoses(table);
+
+    ASSERT_EQ(data, table.data());
+    ASSERT_TRUE(table[b].evaluated);
+    ASSERT_EQ(2, table[b].level);
+    ASSERT_TRUE(poseEq({ { 2, 1, 0 }, { 0, 0, 0, 1 } }, table[b].pose));
+}
+
+TEST(Graphs, snapshot)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    ASSERT_TRUE(graph.snapshot() != nullptr);
+
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 1, 0 } });
+    graph.eval();
+
+    const auto a     = graph.entityHandle("A");
+    const auto first = graph.snapshot();
+    ASSERT_EQ(2, first->poses.size());
+    ASSERT_TRUE(first->poses[a].evaluated);
+    ASSERT_TRUE(poseEq({ { 1, 1, 0 }, { 0, 0, 0, 1 } }, first->poses[a].pose));
+
+    // a held snapshot is not touched by the next evaluations
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 2, 1, 0 } });
+
+    for (int i = 0; i < 5; ++i)
+        graph.eval();
+
+    auto second = graph.snapshot();
+    ASSERT_LT(first->version, second->version);
+    ASSERT_TRUE(poseEq({ { 1, 1, 0 }, { 0, 0, 0, 1 } }, first->poses[a].pose));
+    ASSERT_TRUE(poseEq({ { 2, 1, 0 }, { 0, 0, 0, 1 } }, second->poses[a].pose));
+
+    // the released snapshots are refilled
+    second.reset();
+    std::set<const TransformGraph::PoseSnapshot*> buffers;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        graph.eval();
+        buffers.insert(graph.snapshot().get());
+    }
+
+    ASSERT_LE(buffers.size(), 3);
+    ASSERT_TRUE(poseEq({ { 1, 1, 0 }, { 0, 0, 0, 1 } }, first->poses[a].pose));
+}
+
+TEST(Graphs, staticEntities)
+{
+    TransformGraph graph;
+    graph.addEntity("cam");
+    graph.addEntity("marker");
+    graph.addEntity("drone");
+    graph.setStatic("cam");
+    graph.setStatic("marker");
+
+    // the static entities settle and are frozen
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_FALSE(graph.isFrozen("cam"));
+        graph.updateSensorData({ { "world", "cam", "optitrack", -1 }, { 1, 0, 0 }, tf2::Quaternion(0, 0, 0, 1), 0.1 });
+        graph.updateSensorData({ { "cam", "marker", "cam0", 0 }, { 0, 1, 0 } });
+        graph.eval();
+    }
+
+    ASSERT_TRUE(graph.isFrozen("cam"));
+    ASSERT_TRUE(graph.isFrozen("marker"));
+
+    // the frozen camera locates the drone on its own
+    graph.removeEdgesByKey({ "world", "cam", "optitrack", -1 });
+    graph.updateSensorData({ { "cam", "drone", "cam0", 1 }, { 0, 0, 2 } });
+    graph.eval();
+    ASSERT_TRUE(poseEq({ { 1, 0, 0 }, { 0, 0, 0, 1 } }, graph.lookupPose("cam")));
+    ASSERT_TRUE(poseEq({ { 1, 0, 2 }, { 0, 0, 0, 1 } }, graph.lookupPose("drone")));
+
+    // the edges between static entities do not decay
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // sleep for 20ms
+    graph.removeEdgesOlderThan(ros::Duration(10.0 / 1000.0)); // older than 10ms
+    ASSERT_TRUE(graph.canTransform("cam", "marker"));
+    ASSERT_FALSE(graph.canTransform("cam", "drone"));
+
+    // a deviating measurement re-arms the camera
+    graph.updateSensorData({ { "world", "cam", "optitrack", -1 }, { 2, 0, 0 }, tf2::Quaternion(0, 0, 0, 1), 0.1 });
+    graph.eval();
+    ASSERT_FALSE(graph.isFrozen("cam"));
+    ASSERT_TRUE(graph.isFrozen("marker"));
+    ASSERT_GT(graph.lookupPose("cam").pos.x(), 1.5);
+
+    // not static anymore, the edges decay again
+    graph.setStatic("marker", false);
+    ASSERT_FALSE(graph.isFrozen("marker"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // sleep for 20ms
+    graph.removeEdgesOlderThan(ros::Duration(10.0 / 1000.0)); // older than 10ms
+    ASSERT_FALSE(graph.canTransform("cam", "marker"));
+}
+
+TEST(Graphs, rigidAttachment)
+{
+    TransformGraph graph;
+    graph.addEntity("carrier");
+    graph.attachEntity("gimbal", "carrier", tf2::Transform(tf2::Quaternion({ 0, 0, 1 }, angles::from_degrees(90)), { 0, 0, -1 }));
+    graph.attachEntity("payload", "gimbal", tf2::Transform(tf2::Quaternion(0, 0, 0, 1), { 1, 0, 0 }));
+    graph.addEntity("drone");
+
+    graph.updateSensorData({ { "world", "carrier", "optitrack", -1 }, { 1, 1, 1 } });
+    graph.eval();
+
+    // the attached entities are expanded from their carrier
+    ASSERT_TRUE(poseEq({ { 1, 1, 0 }, tf2::Quaternion({ 0, 0, 1 }, angles::from_degrees(90)) }, graph.lookupPose("gimbal")));
+    ASSERT_TRUE(poseEq({ { 1, 2, 0 }, tf2::Quaternion({ 0, 0, 1 }, angles::from_degrees(90)) }, graph.lookupPose("payload")));
+    ASSERT_EQ(graph.fuseCount("carrier"), graph.fuseCount("payload"));
+
+    TransformGraph::PoseTable table;
+    graph.exportPoses(table);
+    ASSERT_TRUE(table[graph.entityHandle("payload")].evaluated);
+    ASSERT_TRUE(poseEq({ { 1, 2, 0 }, tf2::Quaternion({ 0, 0, 1 }, angles::from_degrees(90)) }, table[graph.entityHandle("payload")].pose));
+
+    // measurements of attached entities are folded into their carrier
+    graph.updateSensorData({ { "payload", "drone", "cam0", 0 }, { 1, 0, 0 } });
+    ASSERT_EQ(4, graph.numberOfEdges());
+    ASSERT_TRUE(graph.canTransform("world", "payload"));
+    ASSERT_TRUE(pathEq({ "world", "carrier", "drone" }, graph.lookupPath("world", "drone")));
+
+    // the fused rotation might have the opposite sign
+    graph.eval();
+    ASSERT_TRUE(vec3Eq({ 1, 3, 0 }, graph.lookupPose("drone").pos));
+    ASSERT_NEAR(0.0, graph.lookupPose("drone").rot.angleShortestPath(tf2::Quaternion({ 0, 0, 1 }, angles::from_degrees(90))), 1e-6);
+
+    auto transform = graph.lookupTransform("payload", "drone");
+    ASSERT_TRUE(poseEq({ { 1, 0, 0 }, { 0, 0, 0, 1 } }, { transform.getOrigin(), transform.getRotation() }));
+
+    transform = graph.lookupTransform("gimbal", "payload");
+    ASSERT_TRUE(poseEq({ { 1, 0, 0 }, { 0, 0, 0, 1 } }, { transform.getOrigin(), transform.getRotation() }));
+
+    // the entities of a rigid body are connected through their carrier
+    ASSERT_TRUE(graph.canTransform("gimbal", "payload"));
+    ASSERT_TRUE(pathEq({ "carrier" }, graph.lookupPath("gimbal", "payload")));
+    ASSERT_TRUE(graph.lookupPath("payload", "payload").empty());
+
+    // measurements within the rigid body do not create a loop on the carrier
+    graph.updateSensorData({ { "payload", "gimbal", "cam1", 1 }, { 0, 0, 1 } });
+    graph.updateSensorData({ { "carrier", "carrier", "cam2", 2 }, { 0, 0, 1 } });
+    ASSERT_EQ(4, graph.numberOfEdges());
+
+    graph.setEvalMode(Options::EvalMode::Optimize, 2);
+    graph.eval();
+    ASSERT_TRUE(poseEq({ { 1, 1, 0 }, tf2::Quaternion({ 0, 0, 1 }, angles::from_degrees(90)) }, graph.lookupPose("gimbal")));
+}
+
+TEST(Graphs, optimizeEval)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.addEntity("B");
+
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 0, 0 } });
+    graph.updateSensorData({ { "world", "B", "optitrack", -2 }, { 2, 0, 0 } });
+
+    // A and B are on the same level, the greedy evaluation ignores their connection
+    graph.updateSensorData({ { "A", "B", "cam0", 0 }, { 1.2, 0, 0 } });
+
+    graph.eval();
+
+    ASSERT_TRUE(vec3Eq({ 1, 0, 0 }, graph.lookupPose("A").pos));
+    ASSERT_TRUE(vec3Eq({ 2, 0, 0 }, graph.lookupPose("B").pos));
+
+    // the least-squares solution of the three measurements
+    graph.setEvalMode(Options::EvalMode::Optimize, 5);
+    graph.eval();
+
+    ASSERT_TRUE(vec3Eq({ 2.8 / 3.0, 0, 0 }, graph.lookupPose("A").pos));
+    ASSERT_TRUE(vec3Eq({ 6.2 / 3.0, 0, 0 }, graph.lookupPose("B").pos));
+    ASSERT_EQ(2, graph.fuseCount("A"));
+
+    // a loop of rotated measurements, consistent with each other
+    const auto yaw = tf2::Quaternion({ 0, 0, 1 }, M_PI_2);
+
+    graph.addEntity("C");
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 0, 0 }, yaw });
+    graph.updateSensorData({ { "world", "B", "optitrack", -2 }, { 1, 1, 0 }, yaw });
+    graph.updateSensorData({ { "A", "B", "cam0", 0 }, { 1, 0, 0 }, tf2::Quaternion::getIdentity() });
+    graph.updateSensorData({ { "B", "C", "cam0", 1 }, { 0, 1, 0 }, yaw });
+    graph.updateSensorData({ { "A", "C", "cam0", 2 }, { 1, 1, 0 }, yaw });
+
+    graph.eval();
+
+    ASSERT_TRUE(vec3Eq({ 1, 1, 0 }, graph.lookupPose("B").pos));
+    ASSERT_TRUE(vec3Eq({ 0, 1, 0 }, graph.lookupPose("C").pos));
+    ASSERT_NEAR(0, graph.lookupPose("C").rot.angleShortestPath(yaw * yaw), 1e-6);
+}
+
+TEST(Graphs, refineEval)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.addEntity("B");
+
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 0, 0 } });
+    graph.updateSensorData({ { "world", "B", "optitrack", -2 }, { 2, 0, 0 } });
+    graph.updateSensorData({ { "A", "B", "cam0", 0 }, { 1.2, 0, 0 } });
+
+    // the sweeps converge to the weighted mean of all the neighbours
+    graph.setRefineBudget(1.0);
+    graph.eval();
+
+    ASSERT_TRUE(vec3Eq({ 2.8 / 3.0, 0, 0 }, graph.lookupPose("A").pos));
+    ASSERT_TRUE(vec3Eq({ 6.2 / 3.0, 0, 0 }, graph.lookupPose("B").pos));
+
+    // without budget the greedy poses are kept
+    graph.setRefineBudget(0.0);
+    graph.clearEvalFlag();
+    graph.eval();
+
+    ASSERT_TRUE(vec3Eq({ 1, 0, 0 }, graph.lookupPose("A").pos));
+    ASSERT_TRUE(vec3Eq({ 2, 0, 0 }, graph.lookupPose("B").pos));
+}
+
+TEST(Graphs, poseHistory)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.attachEntity("A_cam", "A", tf2::Transform(tf2::Quaternion::getIdentity(), { 0, 0, 1 }));
+
+    const auto entity = graph.entityHandle("A");
+    const auto camera = graph.entityHandle("A_cam");
+
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 0, 0 } });
+    graph.eval();
+    const auto first = graph.snapshot()->stamp;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 3, 0, 0 }, tf2::Quaternion({ 0, 0, 1 }, M_PI_2) });
+    graph.eval();
+    const auto second = graph.snapshot()->stamp;
+
+    Pose pose;
+
+    // the stored poses
+    ASSERT_TRUE(graph.lookupPose(entity, first, pose));
+    ASSERT_TRUE(vec3Eq({ 1, 0, 0 }, pose.pos));
+    ASSERT_TRUE(graph.lookupPose(entity, second, pose));
+    ASSERT_TRUE(vec3Eq({ 3, 0, 0 }, pose.pos));
+
+    // halfway in between
+    const auto middle = first + (second - first) * 0.5;
+
+    ASSERT_TRUE(graph.lookupPose(entity, middle, pose));
+    ASSERT_TRUE(vec3Eq({ 2, 0, 0 }, pose.pos));
+    ASSERT_NEAR(M_PI_4, pose.rot.getAngle(), 1e-3);
+
+    ASSERT_TRUE(graph.lookupPose(camera, middle, pose));
+    ASSERT_TRUE(vec3Eq({ 2, 0, 1 }, pose.pos));
+
+    // not covered by the history
+    ASSERT_FALSE(graph.lookupPose(entity, first - ros::Duration(1.0), pose));
+    ASSERT_FALSE(graph.lookupPose(entity, second + ros::Duration(1.0), pose));
+
+    // batch query
+    TransformGraph::PoseTable table;
+    graph.exportPoses(middle, table);
+
+    ASSERT_TRUE(table[entity].evaluated);
+    ASSERT_TRUE(vec3Eq({ 2, 0, 0 }, table[entity].pose.pos));
+
+    // no interpolation across the time the entity was not connected
+    graph.removeAllEdges("A");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    graph.eval();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 5, 0, 0 } });
+    graph.eval();
+    const auto third = graph.snapshot()->stamp;
+
+    ASSERT_FALSE(graph.lookupPose(entity, second + (third - second) * 0.5, pose));
+    ASSERT_TRUE(graph.lookupPose(entity, third, pose));
+    ASSERT_TRUE(vec3Eq({ 5, 0, 0 }, pose.pos));
+}
+
+TEST(Graphs, edgeLifetime)
+{
+    TransformGraph graph(0.25);
+    graph.addEntity("A");
+    graph.addEntity("B");
+    graph.addEntity("C");
+
+    const auto now = ros::Time::now();
+
+    // feeds a sensor at a given interval, the last message arrived at the given age
+    auto feed = [&](const std::string& to, int count, double interval, double age) {
+        for (int i = count - 1; i >= 0; --i)
+        {
+            Measurement measurement({ "world", to, "sensor", 0 }, { 1, 0, 0 });
+            measurement.stamp = now - ros::Duration(age + i * interval);
+            graph.updateSensorData(measurement);
+        }
+    };
+
+    // a slow sensor outlives the decay duration
+    feed("A", 3, 1.0, 1.5);
+
+    // a fast sensor expires after the decay duration
+    feed("B", 20, 0.02, 0.3);
+
+    // a steady sensor survives a few lost messages
+    feed("C", 20, 0.1, 0.5);
+
+    graph.removeExpiredEdges();
+
+    ASSERT_TRUE(graph.canTransform("world", "A"));
+    ASSERT_FALSE(graph.canTransform("world", "B"));
+    ASSERT_TRUE(graph.canTransform("world", "C"));
+
+    // an edge with just a few messages is not established yet
+    graph.addEntity("D");
+    feed("D", 3, 0.1, 0.5);
+    graph.removeExpiredEdges();
+
+    ASSERT_FALSE(graph.canTransform("world", "D"));
+}
+
+TEST(Graphs, removeEntity)
+{
+    TransformGraph graph;
+    graph.addEntity("A");
+    graph.addEntity("B");
+    graph.attachEntity("payload", "A", tf2::Transform(tf2::Quaternion(0, 0, 0, 1), { 0, 0, -1 }));
+
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 0, 0 } });
+    graph.updateSensorData({ { "A", "B", "cam0", 0 }, { 1, 0, 0 } });
+    graph.eval();
+
+    ASSERT_TRUE(graph.canTransform("world", "B"));
+
+    const auto handleA       = graph.entityHandle("A");
+    const auto handlePayload = graph.entityHandle("payload");
+    const auto handleB       = graph.entityHandle("B");
+
+    // the attached entities leave along with their carrier
+    graph.removeEntity("A");
+    graph.eval();
+
+    ASSERT_FALSE(graph.hasEntity("A"));
+    ASSERT_FALSE(graph.hasEntity("payload"));
+    ASSERT_EQ(0, graph.numberOfEdges());
+    ASSERT_FALSE(graph.canTransform("world", "B"));
+    ASSERT_EQ(handleB, graph.entityHandle("B"));
+
+    // data of removed entities is ignored
+    graph.updateSensorData({ { "world", "A", "optitrack", -1 }, { 1, 0, 0 } });
+    ASSERT_EQ(0, graph.numberOfEdges());
+
+    // the world stays
+    graph.removeEntity("world");
+    ASSERT_TRUE(graph.hasEntity("world"));
+
+    // the free slots are reused
+    graph.addEntity("C");
+    graph.addEntity("D");
+
+    const auto handleC = graph.entityHandle("C");
+    const auto handleD = graph.entityHandle("D");
+    ASSERT_TRUE((handleC == handleA && handleD == handlePayload) || (handleC == handlePayload && handleD == handleA));
+
+    graph.updateSensorData({ { "world", "C", "optitrack", -1 }, { 0, 1, 0 } });
+    graph.eval();
+
+    ASSERT_TRUE(vec3Eq({ 0, 1, 0 }, graph.lookupPose("C").pos));
+    ASSERT_FALSE(graph.canTransform("world", "D"));
+    ASSERT_EQ("C", graph.entityName(handleC));
+}
+
+TEST(Graphs, poseComposition)
+{
+    const tf2::Transform a(tf2::Quaternion({ 0, 1, 0 }, angles::from_degrees(30)), { 1, 2, 3 });
+    const tf2::Transform b(tf2::Quaternion({ 1, 0, 1 }, angles::from_degrees(-70)), { -2, 0.5, 4 });
+    const tf2::Transform c(tf2::Quaternion({ 0, 0, 1 }, angles::from_degrees(120)), { 0, 0, -1 });
+
+    const auto expected = a * b * c;
+
+    // the quaternion and translation composition matches the tf2 matrices
+    ASSERT_TRUE(transfEq(expected, (PoseT<double>(a) * PoseT<double>(b) * PoseT<double>(c)).toTransform()));
+    ASSERT_TRUE(transfEq(expected, (PoseT<float>(a) * PoseT<float>(b) * PoseT<float>(c)).toTransform()));
+}
+
+TEST(Graphs, staticLifetime)
+{
+    TransformGraph graph(0.25);
+    graph.addEntity("cam");
+    graph.addEntity("marker");
+    graph.setStatic("cam");
+    graph.setStatic("marker");
+
+    // an established sensor at 10Hz, the last message arrived 0.5s ago
+    const auto now = ros::Time::now();
+
+    for (int i = 19; i >= 0; --i)
+    {
+        Measurement measurement({ "cam", "marker", "cam0", 0 }, { 0, 1, 0 });
+        measurement.stamp = now - ros::Duration(0.5 + i * 0.1);
+        graph.updateSensorData(measurement);
+    }
+
+    graph.removeExpiredEdges();
+    ASSERT_TRUE(graph.canTransform("cam", "marker"));
+
+    // the edge decays again, on the deadline derived from the rate rather than the decay duration
+    // The camera only has the inverse edge of the measurement in its incoming pairs.
+    graph.setStatic("cam", false);
+    graph.removeExpiredEdges();
+    ASSERT_TRUE(graph.canTransform("cam", "marker"));
+
+    // the lifetime of 0.6s (3 intervals, established) runs out
+    std::this_thread::sleep_for(std::chrono::milliseconds(150)); // sleep for 150ms
+    graph.removeExpiredEdges();
+
+    ASSERT_FALSE(graph.canTransform("cam", "marker"));
+    ASSERT_EQ(0, graph.numberOfEdges());
+}
+
+TEST(Graphs, removeAttachedEntity)
+{
+    TransformGraph graph;
+    graph.addEntity("carrier");
+    graph.attachEntity("tracker", "carrier", tf2::Transform(tf2::Quaternion(0, 0, 0, 1), { 0, 0, 1 }));
+
+    // both measurements locate the carrier
+    graph.updateSensorData({ { "world", "carrier", "optitrack", -1 }, { 1, 0, 0 } });
+    graph.updateSensorData({ { "world", "tracker", "optitrack", -1 }, { 3, 0, 1 } });
+    graph.eval();
+
+    ASSERT_TRUE(vec3Eq({ 2, 0, 0 }, graph.lookupPose("carrier").pos));
+
+    // the folded measurement is removed by the name of the attached entity
+    graph.removeAllEdges("tracker");
+    graph.eval();
+
+    ASSERT_EQ(2, graph.numberOfEdges());
+    ASSERT_TRUE(vec3Eq({ 1, 0, 0 }, graph.lookupPose("carrier").pos));
+
+    graph.updateSensorData({ { "world", "tracker", "optitrack", -1 }, { 3, 0, 1 } });
+    ASSERT_EQ(4, graph.numberOfEdges());
+
+    // the folded measurement leaves along with the attached entity
+    graph.removeEntity("tracker");
+    graph.eval();
+
+    ASSERT_TRUE(graph.hasEntity("carrier"));
+    ASSERT_FALSE(graph.hasEntity("tracker"));
+    ASSERT_EQ(2, graph.numberOfEdges());
+    ASSERT_TRUE(vec3Eq({ 1, 0, 0 }, graph.lookupPose("carrier").pos));
+}
+
+TEST(Graphs, expiryOfReusedSlots)
+{
+    TransformGraph graph(0.25);
+    graph.addEntity("A");
+    graph.addEntity("B");
+
+    // the heap entry of this measurement is already due, but left behind by the removal
+    const auto now = ros::Time::now();
+
+    Measurement old({ "world", "A", "optitrack", -1 }, { 1, 0, 0 });
+    old.stamp = now - ros::Duration(1.0);
+    graph.updateSensorData(old);
+    graph.removeEntity("A");
+
+    // a slow sensor gets the freed slots, its inverse edge the former forward edge
+    for (int i = 2; i >= 0; --i)
+    {
+        Measurement measurement({ "world", "B", "optitrack", -2 }, { 1, 0, 0 });
+        measurement.stamp = now - ros::Duration(0.5 + i * 1.0);
+        graph.updateSensorData(measurement);
+    }
+
+    // it outlives the decay duration
+    graph.removeExpiredEdges();
+    ASSERT_TRUE(graph.canTransform("world", "B"));
+    ASSERT_EQ(2, graph.numberOfEdges());
+}
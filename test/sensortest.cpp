@@ -29,3 +29,40 @@ TEST(Sensors, test1)
     // 10 + 5 - 2
     ASSERT_TRUE(vec3Eq({ 13, 0, 0 }, result));
 }
+
+TEST(Sensors, keySymbols)
+{
+    Measurement::Key a("source", "target", "testSensor", 0);
+    Measurement::Key b(std::string("source"), std::string("target"), std::string("testSensor"), 0);
+
+    // equal strings share the same symbol
+    ASSERT_EQ(a.from.id(), b.from.id());
+    ASSERT_TRUE(a == b);
+    ASSERT_EQ(Measurement::Key::Hash()(a), Measurement::Key::Hash()(b));
+
+    ASSERT_EQ("target", a.to.str());
+    ASSERT_NE(a.from, a.to);
+    ASSERT_EQ(-1, SymbolTable::instance().find("neverInterned"));
+}
+
+TEST(Sensors, removeEntity)
+{
+    SensorListener listener;
+
+    Entity drone;
+    drone.name = "drone";
+    listener.addEntity(drone);
+
+    atlas::MarkerData msg;
+    msg.rot.w = 1;
+    msg.sigma = 1.0;
+
+    listener.onSensorDataAvailable("world", "drone", "optitrack", tf2::Transform::getIdentity(), tf2::Transform::getIdentity(), msg);
+    listener.onSensorDataAvailable("world", "other", "optitrack", tf2::Transform::getIdentity(), tf2::Transform::getIdentity(), msg);
+    ASSERT_EQ(2, listener.filteredSensorData().size());
+
+    // the data received from or about the entity is dropped
+    listener.removeEntity("drone");
+    ASSERT_EQ(1, listener.filteredSensorData().size());
+    ASSERT_EQ("other", listener.filteredSensorData().front().key.to.str());
+}